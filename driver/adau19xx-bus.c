@@ -0,0 +1,309 @@
+#include <linux/delay.h>
+#include <linux/device.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/module.h>
+#include <linux/regmap.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+
+#include "adau19xx.h"
+
+//控制总线封装:在I2C/SPI收发外统计每个寄存器的访问次数、字节数、失败次数和延迟
+
+static unsigned int adau19xx_bus_hist_bucket(s64 us) {
+    if (us <= 0)
+        return 0;
+    return min_t(unsigned int, fls64(us), ADAU19XX_BUS_HIST_BUCKETS - 1);
+}
+
+static void adau19xx_bus_account(struct adau19xx_bus *bus, enum adau19xx_bus_op op,
+        unsigned int reg, size_t len, int ret, ktime_t start) {
+    struct adau19xx_bus_stats *st = &bus->stats;
+    s64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+    unsigned int i;
+
+    spin_lock(&st->lock);
+    st->xfers[op]++;
+    st->total_ns[op] += ns;
+    st->hist[op][adau19xx_bus_hist_bucket(div_s64(ns, 1000))]++;
+    if (ret) {
+        if (reg < ADAU19XX_NUM_REGS)
+            st->failures[reg]++;
+    } else {
+        st->bytes[op] += len;
+        //寄存器地址自动递增,连续读写中每个寄存器各计一次
+        for (i = reg; i < reg + len && i < ADAU19XX_NUM_REGS; i++) {
+            if (op == ADAU19XX_BUS_OP_READ)
+                st->reads[i]++;
+            else
+                st->writes[i]++;
+        }
+    }
+    spin_unlock(&st->lock);
+}
+
+//每个寄存器记录一条,多个并发写者通过原子递增head分配槽位
+//phase由调用者在操作开始时取一次,同一次操作(含重试)的各条记录阶段一致
+static void adau19xx_trace_record(struct adau19xx_bus *bus, enum adau19xx_bus_op op, unsigned int phase,
+        unsigned int reg, const u8 *vals, size_t len, int ret) {
+    struct adau19xx_trace *tr = &bus->trace;
+    struct adau19xx_trace_entry *e;
+    u64 ts = ktime_get_ns();
+    size_t i;
+    u32 idx;
+
+    //失败时只记一条,值无意义
+    if (ret)
+        len = 1;
+
+    for (i = 0; i < len; i++, reg++) {
+        idx = atomic_inc_return(&tr->head) - 1;
+        e = &tr->ring[idx & (ADAU19XX_TRACE_ENTRIES - 1)];
+
+        WRITE_ONCE(e->seq, 0);
+        smp_wmb();
+        e->op = op;
+        e->reg = reg;
+        e->phase = phase;
+        e->result = ret;
+        e->ts_ns = ts;
+        if (reg < ADAU19XX_NUM_REGS) {
+            e->old_val = tr->shadow[reg];
+            e->new_val = ret ? tr->shadow[reg] : vals[i];
+            if (!ret)
+                tr->shadow[reg] = vals[i];
+        } else {
+            e->old_val = 0;
+            e->new_val = ret ? 0 : vals[i];
+        }
+        smp_wmb();
+        WRITE_ONCE(e->seq, idx + 1);
+    }
+}
+
+//取最近count条记录(按时间先后),跳过正在写入或已被覆盖的槽位
+unsigned int adau19xx_trace_snapshot(struct adau19xx_bus *bus, struct adau19xx_trace_entry *out,
+        unsigned int count) {
+    struct adau19xx_trace *tr = &bus->trace;
+    const struct adau19xx_trace_entry *e;
+    u32 head = atomic_read(&tr->head);
+    u32 idx, seq;
+    unsigned int n = 0;
+
+    count = min_t(unsigned int, count, ADAU19XX_TRACE_ENTRIES);
+    count = min_t(u32, count, head);
+
+    for (idx = head - count; idx != head; idx++) {
+        e = &tr->ring[idx & (ADAU19XX_TRACE_ENTRIES - 1)];
+        seq = READ_ONCE(e->seq);
+        smp_rmb();
+        out[n] = *e;
+        smp_rmb();
+        if (seq != idx + 1 || READ_ONCE(e->seq) != seq)
+            continue;
+        n++;
+    }
+
+    return n;
+}
+EXPORT_SYMBOL_GPL(adau19xx_trace_snapshot);
+
+void adau19xx_trace_dump(struct adau19xx_bus *bus, struct device *dev, unsigned int count) {
+    struct adau19xx_trace_entry *buf;
+    unsigned int i, n;
+
+    buf = kmalloc_array(count, sizeof (*buf), GFP_KERNEL);
+    if (!buf)
+        return;
+
+    n = adau19xx_trace_snapshot(bus, buf, count);
+    dev_warn(dev, "last %u register operations:\n", n);
+    for (i = 0; i < n; i++) {
+        u64 sec = buf[i].ts_ns;
+        u32 nsec = do_div(sec, NSEC_PER_SEC);
+
+        dev_warn(dev, "  #%u %llu.%06u %s reg 0x%02x 0x%02x->0x%02x phase %u ret %d\n",
+                buf[i].seq - 1, sec, nsec / 1000,
+                buf[i].op == ADAU19XX_BUS_OP_WRITE ? "W" : "R", buf[i].reg,
+                buf[i].old_val, buf[i].new_val, buf[i].phase, buf[i].result);
+    }
+
+    kfree(buf);
+}
+EXPORT_SYMBOL_GPL(adau19xx_trace_dump);
+
+//NAK、仲裁丢失、超时等可能是线缆上的瞬时干扰,参数错误等不重试
+static bool adau19xx_bus_retryable(int ret) {
+    switch (ret) {
+        case -EREMOTEIO:
+        case -ENXIO:
+        case -EIO:
+        case -EAGAIN:
+        case -ETIMEDOUT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+//第attempt次失败后决定是否重试;返回true时已完成退避等待
+static bool adau19xx_bus_should_retry(struct adau19xx_bus *bus, enum adau19xx_bus_op op,
+        unsigned int attempt, int ret) {
+    struct adau19xx_bus_stats *st = &bus->stats;
+    unsigned int delay_us;
+    int err;
+
+    if (attempt >= bus->retries || !adau19xx_bus_retryable(ret))
+        return false;
+
+    //超时通常是从机拉住SDA,先让适配器恢复总线
+    if (ret == -ETIMEDOUT && bus->ops->recover) {
+        err = bus->ops->recover(bus->context);
+        spin_lock(&st->lock);
+        if (err)
+            st->recovery_failures++;
+        else
+            st->recoveries++;
+        spin_unlock(&st->lock);
+    }
+
+    spin_lock(&st->lock);
+    st->retries[op]++;
+    spin_unlock(&st->lock);
+
+    //attempt不超过ADAU19XX_BUS_RETRIES_MAX,移位不会溢出
+    delay_us = ADAU19XX_BUS_RETRY_MIN_US << min_t(unsigned int, attempt, ADAU19XX_BUS_RETRIES_MAX);
+    delay_us = min_t(unsigned int, delay_us, ADAU19XX_BUS_RETRY_MAX_US);
+    usleep_range(delay_us, delay_us * 2);
+
+    return true;
+}
+
+static void adau19xx_bus_retry_done(struct adau19xx_bus *bus, enum adau19xx_bus_op op,
+        unsigned int attempt, int ret) {
+    if (!attempt || ret)
+        return;
+
+    spin_lock(&bus->stats.lock);
+    bus->stats.retry_ok[op]++;
+    spin_unlock(&bus->stats.lock);
+}
+
+static int adau19xx_bus_write(void *context, const void *data, size_t count) {
+    struct adau19xx_bus *bus = context;
+    const u8 *buf = data;
+    unsigned int phase = READ_ONCE(bus->phase);
+    unsigned int attempt = 0;
+    ktime_t start;
+    int ret;
+
+    if (count < bus->reg_bytes)
+        return -EINVAL;
+
+    //耗时统计包含重试,每次尝试都写入飞行记录
+    start = ktime_get();
+    for (;;) {
+        ret = bus->ops->write(bus->context, data, count);
+        adau19xx_trace_record(bus, ADAU19XX_BUS_OP_WRITE, phase, buf[bus->reg_bytes - 1],
+                buf + bus->reg_bytes, count - bus->reg_bytes, ret);
+        if (!ret || !adau19xx_bus_should_retry(bus, ADAU19XX_BUS_OP_WRITE, attempt, ret))
+            break;
+        attempt++;
+    }
+    adau19xx_bus_retry_done(bus, ADAU19XX_BUS_OP_WRITE, attempt, ret);
+    adau19xx_bus_account(bus, ADAU19XX_BUS_OP_WRITE, buf[bus->reg_bytes - 1],
+            count - bus->reg_bytes, ret, start);
+
+    return ret;
+}
+
+static int adau19xx_bus_read(void *context, const void *reg, size_t reg_size, void *val, size_t val_size) {
+    struct adau19xx_bus *bus = context;
+    const u8 *reg_buf = reg;
+    unsigned int phase = READ_ONCE(bus->phase);
+    unsigned int attempt = 0;
+    ktime_t start;
+    int ret;
+
+    if (reg_size != bus->reg_bytes)
+        return -EINVAL;
+
+    start = ktime_get();
+    for (;;) {
+        ret = bus->ops->read(bus->context, reg, reg_size, val, val_size);
+        adau19xx_trace_record(bus, ADAU19XX_BUS_OP_READ, phase, reg_buf[reg_size - 1], val, val_size, ret);
+        if (!ret || !adau19xx_bus_should_retry(bus, ADAU19XX_BUS_OP_READ, attempt, ret))
+            break;
+        attempt++;
+    }
+    adau19xx_bus_retry_done(bus, ADAU19XX_BUS_OP_READ, attempt, ret);
+    adau19xx_bus_account(bus, ADAU19XX_BUS_OP_READ, reg_buf[reg_size - 1], val_size, ret, start);
+
+    return ret;
+}
+
+//不经过regmap,直接从硬件连续读取count个寄存器(一次传输),不读写缓存也不切换cache_bypass;
+//与regmap的读写一样带重试、统计和飞行记录
+int adau19xx_bus_hw_read(struct adau19xx_bus *bus, unsigned int reg, u8 *buf, size_t count) {
+    u8 reg_buf[2] = { 0 };
+
+    if (bus->reg_bytes > sizeof (reg_buf) || reg + count > ADAU19XX_NUM_REGS)
+        return -EINVAL;
+
+    //按regmap的格式组织地址:大端,读标志或到第一个字节
+    reg_buf[bus->reg_bytes - 1] = reg;
+    reg_buf[0] |= bus->read_flag_mask;
+
+    return adau19xx_bus_read(bus, reg_buf, bus->reg_bytes, buf, count);
+}
+EXPORT_SYMBOL_GPL(adau19xx_bus_hw_read);
+
+static const struct regmap_bus adau19xx_regmap_bus = {
+    .write = adau19xx_bus_write,
+    .read = adau19xx_bus_read,
+};
+
+struct adau19xx_bus *adau19xx_bus_alloc(struct device *dev, const struct adau19xx_bus_ops *ops,
+        void *context, unsigned int reg_bytes) {
+    struct adau19xx_bus *bus;
+
+    bus = devm_kzalloc(dev, sizeof (*bus), GFP_KERNEL);
+    if (!bus)
+        return NULL;
+
+    bus->ops = ops;
+    bus->context = context;
+    bus->reg_bytes = reg_bytes;
+    bus->phase = ADAU19XX_PROF_NUM;
+    bus->retries = ADAU19XX_BUS_RETRIES;
+    spin_lock_init(&bus->stats.lock);
+
+    return bus;
+}
+EXPORT_SYMBOL_GPL(adau19xx_bus_alloc);
+
+struct regmap *adau19xx_bus_regmap_init(struct device *dev, struct adau19xx_bus *bus,
+        const struct regmap_config *config) {
+    return devm_regmap_init(dev, &adau19xx_regmap_bus, bus, config);
+}
+EXPORT_SYMBOL_GPL(adau19xx_bus_regmap_init);
+
+void adau19xx_bus_stats_reset(struct adau19xx_bus *bus) {
+    struct adau19xx_bus_stats *st = &bus->stats;
+
+    spin_lock(&st->lock);
+    memset(st->reads, 0, sizeof (st->reads));
+    memset(st->writes, 0, sizeof (st->writes));
+    memset(st->failures, 0, sizeof (st->failures));
+    memset(st->bytes, 0, sizeof (st->bytes));
+    memset(st->xfers, 0, sizeof (st->xfers));
+    memset(st->total_ns, 0, sizeof (st->total_ns));
+    memset(st->hist, 0, sizeof (st->hist));
+    memset(st->retries, 0, sizeof (st->retries));
+    memset(st->retry_ok, 0, sizeof (st->retry_ok));
+    st->recoveries = 0;
+    st->recovery_failures = 0;
+    spin_unlock(&st->lock);
+}
+EXPORT_SYMBOL_GPL(adau19xx_bus_stats_reset);
@@ -0,0 +1,75 @@
+#include <linux/clk-provider.h>
+#include <linux/device.h>
+#include <linux/module.h>
+#include <linux/of.h>
+
+#include "adau19xx.h"
+
+//芯片作为时钟主机时,把输出的BCLK/LRCLK注册为只读时钟,供其他设备(如第二片芯片或DAC)作为时钟源引用
+//dts中引用方式:clocks = <&adau_codec 0>; 0=BCLK 1=LRCLK
+
+#ifdef CONFIG_COMMON_CLK
+
+static unsigned long adau19xx_clk_recalc_rate(struct clk_hw *hw, unsigned long parent_rate) {
+    struct adau19xx_clk *clk = container_of(hw, struct adau19xx_clk, hw);
+
+    return clk->rate;
+}
+
+static const struct clk_ops adau19xx_clk_ops = {
+    .recalc_rate = adau19xx_clk_recalc_rate,
+};
+
+static const char * const adau19xx_clk_names[ADAU19XX_CLK_OUT_NUM] = {
+    [ADAU19XX_CLK_OUT_BCLK] = "bclk",
+    [ADAU19XX_CLK_OUT_LRCLK] = "lrclk",
+};
+
+int adau19xx_clk_init(struct adau1977 *adau19xx) {
+    struct device *dev = adau19xx->dev;
+    struct clk_hw_onecell_data *data;
+    struct clk_init_data init;
+    char name[32];
+    int i, ret;
+
+    if (!of_find_property(dev->of_node, "#clock-cells", NULL))
+        return 0;
+
+    data = devm_kzalloc(dev, sizeof (*data) + ADAU19XX_CLK_OUT_NUM * sizeof (data->hws[0]), GFP_KERNEL);
+    if (!data)
+        return -ENOMEM;
+    data->num = ADAU19XX_CLK_OUT_NUM;
+
+    for (i = 0; i < ADAU19XX_CLK_OUT_NUM; i++) {
+        snprintf(name, sizeof (name), "%s-%s", dev_name(dev), adau19xx_clk_names[i]);
+        init.name = name;
+        init.ops = &adau19xx_clk_ops;
+        init.flags = CLK_GET_RATE_NOCACHE;
+        init.parent_names = NULL;
+        init.num_parents = 0;
+
+        adau19xx->clk_out[i].hw.init = &init;
+        ret = devm_clk_hw_register(dev, &adau19xx->clk_out[i].hw);
+        if (ret) {
+            dev_err(dev, "failed to register %s clock: %d\n", adau19xx_clk_names[i], ret);
+            return ret;
+        }
+        data->hws[i] = &adau19xx->clk_out[i].hw;
+    }
+
+    return devm_of_clk_add_hw_provider(dev, of_clk_hw_onecell_get, data);
+}
+
+#else
+
+int adau19xx_clk_init(struct adau1977 *adau19xx) {
+    return 0;
+}
+
+#endif
+
+//hw_params/hw_free中调用,rate=0表示未输出
+void adau19xx_clk_set_rates(struct adau1977 *adau19xx, unsigned long bclk, unsigned long lrclk) {
+    adau19xx->clk_out[ADAU19XX_CLK_OUT_BCLK].rate = bclk;
+    adau19xx->clk_out[ADAU19XX_CLK_OUT_LRCLK].rate = lrclk;
+}
@@ -1,162 +1,651 @@
+#include <linux/debugfs.h>
+#include <linux/fs.h>
 #include <linux/module.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/string.h>
+#include <linux/uaccess.h>
 #include <sound/soc.h>
 #include "adau19xx.h"
 
-char * adau_reg_name(u8 reg) {
-    char * regname = "";
-    switch (reg) {
-        case ADAU19XX_REG_POWER:
-            regname = "ADAU19XX_REG_POWER";
-            break;
-        case ADAU19XX_REG_PLL:
-            regname = "ADAU19XX_REG_PLL";
-            break;
-        case ADAU19XX_REG_BOOST:
-            regname = "ADAU19XX_REG_BOOST";
-            break;
-        case ADAU19XX_REG_MICBIAS:
-            regname = "ADAU19XX_REG_MICBIAS";
-            break;
-        case ADAU19XX_REG_BLOCK_POWER_SAI:
-            regname = "ADAU19XX_REG_BLOCK_POWER_SAI";
-            break;
-        case ADAU19XX_REG_SAI_CTRL0:
-            regname = "ADAU19XX_REG_SAI_CTRL0";
-            break;
-        case ADAU19XX_REG_SAI_CTRL1:
-            regname = "ADAU19XX_REG_SAI_CTRL1";
-            break;
-        case ADAU19XX_REG_CMAP12:
-            regname = "ADAU19XX_REG_CMAP12";
-            break;
-        case ADAU19XX_REG_CMAP34:
-            regname = "ADAU19XX_REG_CMAP34";
-            break;
-        case ADAU19XX_REG_SAI_OVERTEMP:
-            regname = "ADAU19XX_REG_SAI_OVERTEMP";
-            break;
-        case ADAU19XX_REG_POST_ADC_GAIN(0):
-            regname = "ADAU19XX_REG_POST_ADC_GAIN(0)";
-            break;
-        case ADAU19XX_REG_POST_ADC_GAIN(1):
-            regname = "ADAU19XX_REG_POST_ADC_GAIN(1)";
-            break;
-        case ADAU19XX_REG_POST_ADC_GAIN(2):
-            regname = "ADAU19XX_REG_POST_ADC_GAIN(2)";
-            break;
-        case ADAU19XX_REG_POST_ADC_GAIN(3):
-            regname = "ADAU19XX_REG_POST_ADC_GAIN(3)";
-            break;
-        case ADAU19XX_REG_MISC_CONTROL:
-            regname = "ADAU19XX_REG_MISC_CONTROL";
-            break;
-        case ADAU19XX_REG_ADC_BIAS_CONTROL:
-            regname = "ADAU19XX_REG_ADC_BIAS_CONTROL";
-            break;
-        case ADAU19XX_REG_DIAG_CONTROL:
-            regname = "ADAU19XX_REG_DIAG_CONTROL";
-            break;
-        case ADAU19XX_REG_STATUS(0):
-            regname = "ADAU19XX_REG_STATUS(0)";
-            break;
-        case ADAU19XX_REG_STATUS(1):
-            regname = "ADAU19XX_REG_STATUS(1)";
-            break;
-        case ADAU19XX_REG_STATUS(2):
-            regname = "ADAU19XX_REG_STATUS(2)";
-            break;
-        case ADAU19XX_REG_STATUS(3):
-            regname = "ADAU19XX_REG_STATUS(3)";
-            break;
-        case ADAU19XX_REG_DIAG_IRQ1:
-            regname = "ADAU19XX_REG_DIAG_IRQ1";
-            break;
-        case ADAU19XX_REG_DIAG_IRQ2:
-            regname = "ADAU19XX_REG_DIAG_IRQ2";
-            break;
-        case ADAU19XX_REG_ADJUST1:
-            regname = "ADAU19XX_REG_ADJUST1";
-            break;
-        case ADAU19XX_REG_ADJUST2:
-            regname = "ADAU19XX_REG_ADJUST2";
+void adau19xx_print_msg(struct device *dev, u8 reg, int ret, int value) {
+    const char *regname;
+    regname = adau19xx_reg_name(reg);
+    if (ret) {
+        dev_info(dev, "REG[0x%02x]:%s read/write failed", reg, regname);
+    } else {
+        dev_info(dev, "REG[0x%02x]:%s read/write successed: 0x%02x %d", reg, regname, value);
+    }
+}
+EXPORT_SYMBOL_GPL(adau19xx_print_msg);
+
+//------------------------------------------------------------------------
+//debugfs: 每个芯片一个目录 /sys/kernel/debug/adau19xx-<设备名>/,如adau19xx-1-0071
+//  registers  一次连续读取全部寄存器并列出,dump_cache=1时同时列出缓存值,不一致的行以*标记
+//  raw        二进制读写,文件偏移即寄存器地址,读直接访问硬件;写经过缓存,跳过不可写的寄存器,
+//             驱动独占的位(电源、主静音、直流校准、DAPM使能)保持原值,读出的整张映像可原样写回
+//  dump_cache 0/1
+//  status     上电/看门狗等状态
+//  phases     打开录音流各阶段耗时(min/avg/max/p99),写入任意内容清零
+//  trace      最近256次寄存器操作:时间、寄存器、旧值/新值、调用阶段和结果
+//  power      各bias level、上电/断电、同时上电ADC数、升压/MICBIAS的累计时间,写入任意内容清零
+//  profiles   命名寄存器配置,写入"名称 寄存器=值 ..."替换已有配置,声卡注册前也可新增
+//  bus_stats  控制总线按寄存器的读写次数、字节数、失败次数和延迟直方图,写入任意内容清零
+static bool adau19xx_debugfs_readable(struct adau1977 *adau19xx, unsigned int reg) {
+    return adau19xx->variant->regmap_config->readable_reg(adau19xx->dev, reg);
+}
+
+static bool adau19xx_debugfs_writeable(struct adau1977 *adau19xx, unsigned int reg) {
+    return adau19xx->variant->regmap_config->writeable_reg(adau19xx->dev, reg);
+}
+
+static bool adau19xx_debugfs_volatile(struct adau1977 *adau19xx, unsigned int reg) {
+    return adau19xx->variant->regmap_config->volatile_reg(adau19xx->dev, reg);
+}
+
+//从硬件读取[reg, reg + count),每段连续可读寄存器一次传输;
+//当前型号不可读的寄存器(如ADAU1978/1979没有的升压/诊断寄存器)不访问,填0
+static int adau19xx_debugfs_hw_read(struct adau1977 *adau19xx, unsigned int first, u8 *buf, size_t count) {
+    unsigned int end = first + count, start = first, reg;
+    int ret = 0;
+
+    memset(buf, 0, count);
+
+    mutex_lock(&adau19xx->lock);
+    if (!adau19xx->enabled)
+        ret = -EBUSY;
+
+    while (!ret && start < end) {
+        if (!adau19xx_debugfs_readable(adau19xx, start)) {
+            start++;
+            continue;
+        }
+        for (reg = start; reg < end && adau19xx_debugfs_readable(adau19xx, reg); reg++)
+            ;
+        ret = adau19xx_hw_bulk_read(adau19xx, start, buf + start - first, reg - start);
+        start = reg;
+    }
+    mutex_unlock(&adau19xx->lock);
+
+    return ret;
+}
+
+static int adau19xx_registers_show(struct seq_file *s, void *data) {
+    struct adau1977 *adau19xx = s->private;
+    u8 hw[ADAU19XX_NUM_REGS];
+    unsigned int cache;
+    int reg, ret;
+
+    ret = adau19xx_debugfs_hw_read(adau19xx, 0, hw, ADAU19XX_NUM_REGS);
+    if (ret) {
+        seq_printf(s, "hardware read failed: %d\n", ret);
+        return 0;
+    }
+
+    for (reg = 0; reg < ADAU19XX_NUM_REGS; reg++) {
+        if (!adau19xx_debugfs_readable(adau19xx, reg)) {
+            seq_printf(s, "0x%02x %-32s --\n", reg, adau19xx_reg_name(reg));
+            continue;
+        }
+        seq_printf(s, "0x%02x %-32s 0x%02x", reg, adau19xx_reg_name(reg), hw[reg]);
+        //易失寄存器没有缓存,regmap_read会再读一次硬件,ADC_CLIP还会被清零
+        if (adau19xx->debugfs_dump_cache && adau19xx_debugfs_volatile(adau19xx, reg))
+            seq_puts(s, " uncached");
+        else if (adau19xx->debugfs_dump_cache && regmap_read(adau19xx->regmap, reg, &cache) == 0)
+            seq_printf(s, " cache 0x%02x%s", cache, cache != hw[reg] ? " *" : "");
+        seq_puts(s, "\n");
+    }
+
+    return 0;
+}
+
+static int adau19xx_registers_open(struct inode *inode, struct file *file) {
+    return single_open(file, adau19xx_registers_show, inode->i_private);
+}
+
+static const struct file_operations adau19xx_registers_fops = {
+    .owner = THIS_MODULE,
+    .open = adau19xx_registers_open,
+    .read = seq_read,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+static ssize_t adau19xx_raw_read(struct file *file, char __user *user_buf, size_t count, loff_t *ppos) {
+    struct adau1977 *adau19xx = file->private_data;
+    u8 buf[ADAU19XX_NUM_REGS];
+    loff_t pos = *ppos;
+    int ret;
+
+    if (pos < 0)
+        return -EINVAL;
+    if (pos >= ADAU19XX_NUM_REGS || count == 0)
+        return 0;
+    count = min_t(size_t, count, ADAU19XX_NUM_REGS - pos);
+
+    ret = adau19xx_debugfs_hw_read(adau19xx, pos, buf, count);
+    if (ret)
+        return ret;
+
+    if (copy_to_user(user_buf, buf, count))
+        return -EFAULT;
+
+    *ppos = pos + count;
+    return count;
+}
+
+static ssize_t adau19xx_raw_write(struct file *file, const char __user *user_buf, size_t count, loff_t *ppos) {
+    struct adau1977 *adau19xx = file->private_data;
+    u8 buf[ADAU19XX_NUM_REGS];
+    loff_t pos = *ppos;
+    unsigned int i, mask;
+    int ret;
+
+    if (pos < 0)
+        return -EINVAL;
+    if (pos >= ADAU19XX_NUM_REGS || count == 0)
+        return -ENOSPC;
+    count = min_t(size_t, count, ADAU19XX_NUM_REGS - pos);
+
+    if (copy_from_user(buf, user_buf, count))
+        return -EFAULT;
+
+    //经过缓存逐个写入,保证缓存与硬件一致;与adi,init-regs和寄存器配置一样不碰驱动独占的位
+    for (i = 0; i < count; i++) {
+        mask = ~adau19xx_reg_owned_bits(pos + i) & 0xff;
+        if (!mask || !adau19xx_debugfs_writeable(adau19xx, pos + i))
+            continue;
+        ret = regmap_update_bits(adau19xx->regmap, pos + i, mask, buf[i]);
+        if (ret)
+            return ret;
+    }
+
+    *ppos = pos + count;
+    return count;
+}
+
+static const struct file_operations adau19xx_raw_fops = {
+    .owner = THIS_MODULE,
+    .open = simple_open,
+    .read = adau19xx_raw_read,
+    .write = adau19xx_raw_write,
+    .llseek = default_llseek,
+};
+
+static int adau19xx_status_show(struct seq_file *s, void *data) {
+    struct adau1977 *adau19xx = s->private;
+
+    seq_printf(s, "variant: %s\n", adau19xx->variant->name);
+    seq_printf(s, "enabled: %d\n", adau19xx->enabled);
+    seq_printf(s, "sysclk_src: %d\n", adau19xx->sysclk_src);
+    seq_printf(s, "clk_src: %s\n", adau19xx->clk_src == ADAU19XX_SYSCLK_SRC_MCLK ? "mclk" : "lrclk");
+    seq_printf(s, "master: %d\n", adau19xx->master);
+    if (adau19xx->master)
+        seq_printf(s, "bclk: %lu lrclk: %lu\n", adau19xx->clk_out[ADAU19XX_CLK_OUT_BCLK].rate,
+                adau19xx->clk_out[ADAU19XX_CLK_OUT_LRCLK].rate);
+    seq_printf(s, "dc_cal_done: %d pending: %d\n", adau19xx->dc_cal_done, adau19xx->dc_cal_pending);
+    seq_printf(s, "power_up_us: gpio %u reset %u sync %u pll %u\n",
+            adau19xx->pwr_phase_us[ADAU19XX_PWR_PHASE_GPIO],
+            adau19xx->pwr_phase_us[ADAU19XX_PWR_PHASE_RESET],
+            adau19xx->pwr_phase_us[ADAU19XX_PWR_PHASE_SYNC],
+            adau19xx->pwr_phase_us[ADAU19XX_PWR_PHASE_PLL]);
+    seq_printf(s, "watchdog_ms: %u\n", adau19xx->watchdog_ms);
+    seq_printf(s, "watchdog_checks: %u\n", adau19xx->wdt_checks);
+    seq_printf(s, "watchdog_recoveries: %u\n", adau19xx->wdt_recoveries);
+    if (adau19xx->group)
+        seq_printf(s, "sync_group: %u active %d armed %d running %d\n", adau19xx->group->id,
+                adau19xx->group_active, adau19xx->group_armed, adau19xx->group_running);
+
+    return 0;
+}
+
+static int adau19xx_status_open(struct inode *inode, struct file *file) {
+    return single_open(file, adau19xx_status_show, inode->i_private);
+}
+
+static const struct file_operations adau19xx_status_fops = {
+    .owner = THIS_MODULE,
+    .open = adau19xx_status_open,
+    .read = seq_read,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+static const char *const adau19xx_bus_op_names[ADAU19XX_BUS_OP_NUM] = {
+    [ADAU19XX_BUS_OP_READ] = "read",
+    [ADAU19XX_BUS_OP_WRITE] = "write",
+};
+
+static int adau19xx_bus_stats_show(struct seq_file *s, void *data) {
+    struct adau19xx_bus *bus = s->private;
+    struct adau19xx_bus_stats *st;
+    int reg, op, i;
+
+    //先复制一份,避免持锁打印
+    st = kmalloc(sizeof (*st), GFP_KERNEL);
+    if (!st)
+        return -ENOMEM;
+    spin_lock(&bus->stats.lock);
+    memcpy(st, &bus->stats, sizeof (*st));
+    spin_unlock(&bus->stats.lock);
+
+    seq_puts(s, "reg  name                             reads   writes failures\n");
+    for (reg = 0; reg < ADAU19XX_NUM_REGS; reg++) {
+        if (!st->reads[reg] && !st->writes[reg] && !st->failures[reg])
+            continue;
+        seq_printf(s, "0x%02x %-32s %6u %8u %8u\n", reg, adau19xx_reg_name(reg),
+                st->reads[reg], st->writes[reg], st->failures[reg]);
+    }
+
+    for (op = 0; op < ADAU19XX_BUS_OP_NUM; op++) {
+        seq_printf(s, "\n%s: xfers %u bytes %llu avg_us %llu\n", adau19xx_bus_op_names[op],
+                st->xfers[op], st->bytes[op],
+                st->xfers[op] ? div64_u64(st->total_ns[op], st->xfers[op] * 1000ULL) : 0);
+        for (i = 0; i < ADAU19XX_BUS_HIST_BUCKETS; i++) {
+            if (!st->hist[op][i])
+                continue;
+            seq_printf(s, "  <%6uus %u\n", 1U << i, st->hist[op][i]);
+        }
+        seq_printf(s, "  retries %u recovered_by_retry %u\n", st->retries[op], st->retry_ok[op]);
+    }
+
+    seq_printf(s, "\nretry_limit: %u\n", bus->retries);
+    seq_printf(s, "bus_recoveries: %u failed %u\n", st->recoveries, st->recovery_failures);
+
+    kfree(st);
+    return 0;
+}
+
+static int adau19xx_bus_stats_open(struct inode *inode, struct file *file) {
+    return single_open(file, adau19xx_bus_stats_show, inode->i_private);
+}
+
+static ssize_t adau19xx_bus_stats_write(struct file *file, const char __user *user_buf, size_t count, loff_t *ppos) {
+    struct seq_file *s = file->private_data;
+
+    adau19xx_bus_stats_reset(s->private);
+    return count;
+}
+
+static const struct file_operations adau19xx_bus_stats_fops = {
+    .owner = THIS_MODULE,
+    .open = adau19xx_bus_stats_open,
+    .read = seq_read,
+    .write = adau19xx_bus_stats_write,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+//------------------------------------------------------------------------
+//打开录音流各阶段耗时统计
+void adau19xx_prof_record(struct adau1977 *adau19xx, enum adau19xx_prof_phase phase, ktime_t start) {
+    struct adau19xx_prof_stats *ps = &adau19xx->prof[phase];
+    u64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+    spin_lock(&adau19xx->prof_lock);
+    if (!ps->count || ns < ps->min_ns)
+        ps->min_ns = ns;
+    if (ns > ps->max_ns)
+        ps->max_ns = ns;
+    ps->total_ns += ns;
+    ps->samples_us[ps->count % ADAU19XX_PROF_SAMPLES] = div_u64(ns, 1000);
+    ps->count++;
+    spin_unlock(&adau19xx->prof_lock);
+}
+EXPORT_SYMBOL_GPL(adau19xx_prof_record);
+
+static const char *const adau19xx_prof_names[ADAU19XX_PROF_NUM] = {
+    [ADAU19XX_PROF_STARTUP] = "startup",
+    [ADAU19XX_PROF_SYSCLK] = "set_sysclk",
+    [ADAU19XX_PROF_SET_FMT] = "set_fmt",
+    [ADAU19XX_PROF_HW_PARAMS] = "hw_params",
+    [ADAU19XX_PROF_BIAS_OFF] = "bias_off",
+    [ADAU19XX_PROF_BIAS_STANDBY] = "bias_standby",
+    [ADAU19XX_PROF_BIAS_PREPARE] = "bias_prepare",
+    [ADAU19XX_PROF_BIAS_ON] = "bias_on",
+    [ADAU19XX_PROF_PLL_SETTLE] = "pll_settle",
+    [ADAU19XX_PROF_UNMUTE] = "unmute",
+    [ADAU19XX_PROF_STREAM_OPEN] = "stream_open",
+    [ADAU19XX_PROF_POWER_UP] = "power_up",
+    [ADAU19XX_PROF_RECOVER] = "recover",
+};
+
+static int adau19xx_cmp_u32(const void *a, const void *b) {
+    u32 x = *(const u32 *) a, y = *(const u32 *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+static int adau19xx_phases_show(struct seq_file *s, void *data) {
+    struct adau1977 *adau19xx = s->private;
+    struct adau19xx_prof_stats *ps;
+    unsigned int n;
+    int i;
+
+    ps = kmalloc(sizeof (*ps), GFP_KERNEL);
+    if (!ps)
+        return -ENOMEM;
+
+    seq_puts(s, "phase              count     min_us     avg_us     max_us     p99_us\n");
+    for (i = 0; i < ADAU19XX_PROF_NUM; i++) {
+        spin_lock(&adau19xx->prof_lock);
+        memcpy(ps, &adau19xx->prof[i], sizeof (*ps));
+        spin_unlock(&adau19xx->prof_lock);
+
+        if (!ps->count)
+            continue;
+
+        //p99取最近ADAU19XX_PROF_SAMPLES个样本
+        n = min_t(unsigned int, ps->count, ADAU19XX_PROF_SAMPLES);
+        sort(ps->samples_us, n, sizeof (u32), adau19xx_cmp_u32, NULL);
+
+        seq_printf(s, "%-14s %9u %10llu %10llu %10llu %10u\n", adau19xx_prof_names[i], ps->count,
+                div_u64(ps->min_ns, 1000), div_u64(div_u64(ps->total_ns, ps->count), 1000),
+                div_u64(ps->max_ns, 1000), ps->samples_us[DIV_ROUND_UP(n * 99, 100) - 1]);
+    }
+
+    kfree(ps);
+    return 0;
+}
+
+static int adau19xx_phases_open(struct inode *inode, struct file *file) {
+    return single_open(file, adau19xx_phases_show, inode->i_private);
+}
+
+static ssize_t adau19xx_phases_write(struct file *file, const char __user *user_buf, size_t count, loff_t *ppos) {
+    struct seq_file *s = file->private_data;
+    struct adau1977 *adau19xx = s->private;
+
+    spin_lock(&adau19xx->prof_lock);
+    memset(adau19xx->prof, 0, sizeof (adau19xx->prof));
+    spin_unlock(&adau19xx->prof_lock);
+    return count;
+}
+
+static const struct file_operations adau19xx_phases_fops = {
+    .owner = THIS_MODULE,
+    .open = adau19xx_phases_open,
+    .read = seq_read,
+    .write = adau19xx_phases_write,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+//------------------------------------------------------------------------
+//电源状态停留时间:状态变化时先把上次结算以来的时间记到旧状态上
+static void adau19xx_res_account(struct adau19xx_residency *res, ktime_t now) {
+    u64 ns = ktime_to_ns(ktime_sub(now, res->since));
+
+    res->since = now;
+    res->bias_ns[res->bias] += ns;
+    if (res->powered)
+        res->powered_ns += ns;
+    else
+        res->off_ns += ns;
+    res->adcs_ns[res->num_adcs] += ns;
+    if (res->boost)
+        res->boost_ns += ns;
+    if (res->micbias)
+        res->micbias_ns += ns;
+}
+
+void adau19xx_res_set(struct adau1977 *adau19xx, enum adau19xx_res_item item, int value) {
+    struct adau19xx_residency *res = &adau19xx->res;
+
+    spin_lock(&adau19xx->res_lock);
+    adau19xx_res_account(res, ktime_get_boottime());
+    switch (item) {
+        case ADAU19XX_RES_BIAS:
+            if (value >= ADAU19XX_RES_BIAS_LEVELS)
+                break;
+            if (res->bias != value)
+                res->bias_enters[value]++;
+            res->bias = value;
             break;
-        case ADAU19XX_REG_ADC_CLIP:
-            regname = "ADAU19XX_REG_ADC_CLIP";
+        case ADAU19XX_RES_POWERED:
+            if (value && !res->powered)
+                res->power_ups++;
+            res->powered = value;
             break;
-        case ADAU19XX_REG_DC_HPF_CAL:
-            regname = "ADAU19XX_REG_DC_HPF_CAL";
+        case ADAU19XX_RES_ADCS:
+            if (value > 0 && res->num_adcs < ADAU19XX_RES_MAX_ADCS)
+                res->num_adcs++;
+            else if (value < 0 && res->num_adcs > 0)
+                res->num_adcs--;
             break;
-        case ADAU19XX_REG_TWEAK1:
-            regname = "ADAU19XX_REG_TWEAK1";
+        case ADAU19XX_RES_BOOST:
+            res->boost = value;
             break;
-        default:
+        case ADAU19XX_RES_MICBIAS:
+            res->micbias = value;
             break;
     }
-    return regname;
+    spin_unlock(&adau19xx->res_lock);
 }
+EXPORT_SYMBOL_GPL(adau19xx_res_set);
 
-void adau19xx_print_msg(u8 reg, int ret, int value) {
-    char *regname;
-    regname = adau_reg_name(reg);
-    if (ret) {
-        pr_info("REG[0x%02x]:%s read/write failed", reg, regname);
-    } else {
-        pr_info("REG[0x%02x]:%s read/write successed: 0x%02x %d", reg, regname, value);
+static const char *const adau19xx_bias_names[ADAU19XX_RES_BIAS_LEVELS] = {
+    [SND_SOC_BIAS_OFF] = "off",
+    [SND_SOC_BIAS_STANDBY] = "standby",
+    [SND_SOC_BIAS_PREPARE] = "prepare",
+    [SND_SOC_BIAS_ON] = "on",
+};
+
+static int adau19xx_power_show(struct seq_file *s, void *data) {
+    struct adau1977 *adau19xx = s->private;
+    struct adau19xx_residency res;
+    u64 total;
+    int i;
+
+    //结算到当前时刻再复制,正在停留的状态也计入
+    spin_lock(&adau19xx->res_lock);
+    adau19xx_res_account(&adau19xx->res, ktime_get_boottime());
+    res = adau19xx->res;
+    spin_unlock(&adau19xx->res_lock);
+
+    total = res.powered_ns + res.off_ns;
+    seq_printf(s, "state: bias %s powered %d adcs %u boost %d micbias %d\n",
+            adau19xx_bias_names[res.bias], res.powered, res.num_adcs, res.boost, res.micbias);
+    seq_printf(s, "total_ms: %llu\n", div_u64(total, NSEC_PER_MSEC));
+    seq_printf(s, "powered_ms: %llu off_ms: %llu power_ups: %u\n",
+            div_u64(res.powered_ns, NSEC_PER_MSEC), div_u64(res.off_ns, NSEC_PER_MSEC), res.power_ups);
+    for (i = 0; i < ADAU19XX_RES_BIAS_LEVELS; i++)
+        seq_printf(s, "bias_%s_ms: %llu enters: %u\n", adau19xx_bias_names[i],
+                div_u64(res.bias_ns[i], NSEC_PER_MSEC), res.bias_enters[i]);
+    for (i = 0; i <= ADAU19XX_RES_MAX_ADCS; i++)
+        seq_printf(s, "adcs_%d_ms: %llu\n", i, div_u64(res.adcs_ns[i], NSEC_PER_MSEC));
+    seq_printf(s, "boost_ms: %llu\n", div_u64(res.boost_ns, NSEC_PER_MSEC));
+    seq_printf(s, "micbias_ms: %llu\n", div_u64(res.micbias_ns, NSEC_PER_MSEC));
+
+    return 0;
+}
+
+static int adau19xx_power_open(struct inode *inode, struct file *file) {
+    return single_open(file, adau19xx_power_show, inode->i_private);
+}
+
+//清零累计值,保留当前状态
+static ssize_t adau19xx_power_write(struct file *file, const char __user *user_buf, size_t count, loff_t *ppos) {
+    struct seq_file *s = file->private_data;
+    struct adau1977 *adau19xx = s->private;
+    struct adau19xx_residency *res = &adau19xx->res;
+
+    spin_lock(&adau19xx->res_lock);
+    memset(res->bias_ns, 0, sizeof (res->bias_ns));
+    memset(res->bias_enters, 0, sizeof (res->bias_enters));
+    memset(res->adcs_ns, 0, sizeof (res->adcs_ns));
+    res->powered_ns = 0;
+    res->off_ns = 0;
+    res->power_ups = 0;
+    res->boost_ns = 0;
+    res->micbias_ns = 0;
+    res->since = ktime_get_boottime();
+    spin_unlock(&adau19xx->res_lock);
+    return count;
+}
+
+static const struct file_operations adau19xx_power_fops = {
+    .owner = THIS_MODULE,
+    .open = adau19xx_power_open,
+    .read = seq_read,
+    .write = adau19xx_power_write,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+//------------------------------------------------------------------------
+//飞行记录器
+static int adau19xx_trace_show(struct seq_file *s, void *data) {
+    struct adau19xx_bus *bus = s->private;
+    struct adau19xx_trace_entry *buf;
+    unsigned int i, n;
+
+    buf = kmalloc_array(ADAU19XX_TRACE_ENTRIES, sizeof (*buf), GFP_KERNEL);
+    if (!buf)
+        return -ENOMEM;
+
+    n = adau19xx_trace_snapshot(bus, buf, ADAU19XX_TRACE_ENTRIES);
+    seq_puts(s, "seq        time_ns          op reg  old  new  phase          ret\n");
+    for (i = 0; i < n; i++) {
+        seq_printf(s, "%-10u %-16llu %s  0x%02x 0x%02x 0x%02x %-14s %d\n",
+                buf[i].seq - 1, buf[i].ts_ns,
+                buf[i].op == ADAU19XX_BUS_OP_WRITE ? "W" : "R", buf[i].reg,
+                buf[i].old_val, buf[i].new_val,
+                buf[i].phase < ADAU19XX_PROF_NUM ? adau19xx_prof_names[buf[i].phase] : "-",
+                buf[i].result);
     }
+
+    kfree(buf);
+    return 0;
+}
+
+static int adau19xx_trace_open(struct inode *inode, struct file *file) {
+    return single_open(file, adau19xx_trace_show, inode->i_private);
 }
-EXPORT_SYMBOL_GPL(adau19xx_print_msg);
 
-void adau19xx_do_store(struct device *dev, const char *buf, size_t count) {
-    struct adau1977 *adau = dev_get_drvdata(dev);
-    int val = 0, flag = 0;
-    u8 i = 0, reg, num, value_w;
-    int ret = 0, value_r;
+static const struct file_operations adau19xx_trace_fops = {
+    .owner = THIS_MODULE,
+    .open = adau19xx_trace_open,
+    .read = seq_read,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
 
-    val = simple_strtol(buf, NULL, 16);
-    flag = (val >> 16) & 0xF;
+//------------------------------------------------------------------------
+//命名寄存器配置:读出全部配置,当前配置以*标记;写入"名称 寄存器=值 ..."替换一个配置,
+//Register Profile控件注册后不能新增名称(返回-EBUSY)
+static int adau19xx_profiles_show(struct seq_file *s, void *data) {
+    struct adau1977 *adau19xx = s->private;
+    const struct adau19xx_profile *p;
+    unsigned int i, j;
 
-    pr_info("val= 0x%02x , flag=0x%02x\n", val, flag);
+    mutex_lock(&adau19xx->lock);
+    for (i = 0; i < adau19xx->num_profiles; i++) {
+        p = &adau19xx->profiles[i];
+        seq_printf(s, "%c%s", adau19xx->cur_profile == i + 1 ? '*' : ' ', p->name);
+        for (j = 0; j < p->num_regs; j++)
+            seq_printf(s, " 0x%02x=0x%02x", p->regs[j].reg, p->regs[j].def);
+        seq_putc(s, '\n');
+    }
+    mutex_unlock(&adau19xx->lock);
 
+    return 0;
+}
 
-    if (flag) {
-        reg = (val >> 8) & 0xFF;
-        value_w = val & 0xFF;
-        regcache_cache_bypass(adau->regmap, true);
-        ret = regmap_write(adau->regmap, reg, value_w);
-        regcache_cache_bypass(adau->regmap, false);
-        adau19xx_print_msg(reg, ret, value_w);
-    } else {
-        reg = (val >> 8) & 0xFF;
-        num = val & 0xff;
-        pr_info("===================================\n");
-        pr_info("Read: start REG:0x%02x,count:0x%02x\n", reg, num);
-
-        do {
-            value_r = 0;
-            regcache_cache_bypass(adau->regmap, true);
-            ret = regmap_read(adau->regmap, reg, &value_r);
-            regcache_cache_bypass(adau->regmap, false);
-            pr_info("-----------------------------------\n");
-            adau19xx_print_msg(reg, ret, value_r);
-            reg++;
-            i++;
-        } while (i <= num);
-        pr_info("===================================\n");
+static int adau19xx_profiles_open(struct inode *inode, struct file *file) {
+    return single_open(file, adau19xx_profiles_show, inode->i_private);
+}
+
+static ssize_t adau19xx_profiles_write(struct file *file, const char __user *user_buf, size_t count, loff_t *ppos) {
+    struct seq_file *s = file->private_data;
+    struct adau1977 *adau19xx = s->private;
+    struct reg_sequence *regs;
+    char buf[256], *cur, *tok, *name, *val;
+    unsigned int num = 0, reg, v;
+    int ret;
+
+    if (count >= sizeof (buf))
+        return -EINVAL;
+    if (copy_from_user(buf, user_buf, count))
+        return -EFAULT;
+    buf[count] = '\0';
+
+    cur = strim(buf);
+    name = strsep(&cur, " ");
+    if (!cur)
+        return -EINVAL;
+
+    regs = devm_kcalloc(adau19xx->dev, ADAU19XX_NUM_REGS, sizeof (*regs), GFP_KERNEL);
+    if (!regs)
+        return -ENOMEM;
+
+    while ((tok = strsep(&cur, " ")) != NULL) {
+        if (!*tok)
+            continue;
+        val = strchr(tok, '=');
+        ret = -EINVAL;
+        if (!val || num >= ADAU19XX_NUM_REGS)
+            goto err;
+        *val++ = '\0';
+        ret = kstrtouint(tok, 0, &reg);
+        if (!ret)
+            ret = kstrtouint(val, 0, &v);
+        if (ret)
+            goto err;
+        regs[num].reg = reg;
+        regs[num].def = v;
+        num++;
     }
+
+    ret = adau19xx_profile_set(adau19xx, name, regs, num);
+    if (ret)
+        goto err;
+
+    return count;
+err:
+    devm_kfree(adau19xx->dev, regs);
+    return ret;
 }
-EXPORT_SYMBOL_GPL(adau19xx_do_store);
 
-void adau19xx_do_show(void) {
-    pr_info("echo flag|reg|val > adau\n");
-    pr_info("eg read[0x00] all value:from reg[0x00] to reg[0x1a] :echo 0001a > adau\n");
-    pr_info("eg read[0x00] ADAU19XX_REG_POWER value: reg[0x00] count[0x01] :echo 00001 > adau\n");
-    pr_info("eg write[0x01] value[0x01] to reg[0x00] :echo 10001 > adau\n");
-    //pr_info("ADAU19XX_POWER_RESET:0x%02x , ADAU19XX_POWER_PWUP:0x%02x\n", ADAU19XX_POWER_RESET, ADAU19XX_POWER_PWUP);
-    pr_info("ADAU19XX_POWER_RESET:echo 10080 > adau\n");
-    pr_info("ADAU19XX_POWER_PWUP:echo 10001 > adau\n");
+static const struct file_operations adau19xx_profiles_fops = {
+    .owner = THIS_MODULE,
+    .open = adau19xx_profiles_open,
+    .read = seq_read,
+    .write = adau19xx_profiles_write,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+static void adau19xx_debugfs_remove(void *data) {
+    struct adau1977 *adau19xx = data;
+
+    debugfs_remove_recursive(adau19xx->debugfs);
+    adau19xx->debugfs = NULL;
 }
-EXPORT_SYMBOL_GPL(adau19xx_do_show);
 
-MODULE_DESCRIPTION("ASoC ADAU19XX driver");
-MODULE_AUTHOR("Benjamin Wan<32132145@qq.com>");
-MODULE_LICENSE("GPL");
+void adau19xx_debugfs_init(struct adau1977 *adau19xx) {
+    struct dentry *dir;
+    char name[48];
+
+    snprintf(name, sizeof (name), "adau19xx-%s", dev_name(adau19xx->dev));
+    dir = debugfs_create_dir(name, NULL);
+    if (IS_ERR_OR_NULL(dir)) {
+        dev_warn(adau19xx->dev, "failed to create debugfs dir\n");
+        return;
+    }
+    adau19xx->debugfs = dir;
+
+    debugfs_create_file("registers", 0444, dir, adau19xx, &adau19xx_registers_fops);
+    debugfs_create_file("raw", 0600, dir, adau19xx, &adau19xx_raw_fops);
+    debugfs_create_bool("dump_cache", 0644, dir, &adau19xx->debugfs_dump_cache);
+    debugfs_create_file("status", 0444, dir, adau19xx, &adau19xx_status_fops);
+    debugfs_create_file("phases", 0644, dir, adau19xx, &adau19xx_phases_fops);
+    debugfs_create_file("profiles", 0644, dir, adau19xx, &adau19xx_profiles_fops);
+    debugfs_create_file("power", 0644, dir, adau19xx, &adau19xx_power_fops);
+    debugfs_create_file("bus_stats", 0644, dir, adau19xx->bus, &adau19xx_bus_stats_fops);
+    debugfs_create_file("trace", 0444, dir, adau19xx->bus, &adau19xx_trace_fops);
+
+    devm_add_action_or_reset(adau19xx->dev, adau19xx_debugfs_remove, adau19xx);
+}
+EXPORT_SYMBOL_GPL(adau19xx_debugfs_init);
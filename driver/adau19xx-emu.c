@@ -0,0 +1,577 @@
+#include <linux/debugfs.h>
+#include <linux/delay.h>
+#include <linux/i2c.h>
+#include <linux/module.h>
+#include <linux/platform_device.h>
+#include <linux/property.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/uaccess.h>
+#include <sound/soc.h>
+
+#include "adau19xx.h"
+
+//ADAU1977/1978/1979寄存器模型,用于没有芯片的机器上做驱动集成测试
+//两种接入方式共用同一个模型:
+//  1.虚拟I2C适配器(默认):加载后注册适配器adau19xx-emu,在0x11创建codec设备和一张以snd-soc-dummy为CPU端的测试声卡,
+//    snd-soc-adau19xx可以完成probe、regcache_sync和hw_params
+//  2.i2c-slave后端:在支持从机模式的适配器上 echo slave-adau1977 0x1011 > new_device,由另一条总线上的驱动访问
+//模型行为:
+//  寄存器默认值、可写规则和型号差异取自adau19xx.h中的寄存器描述表
+//  写POWER的RESET位恢复全部默认值,RESET位自动清零
+//  STATUS/ADC_CLIP只读,值由debugfs的inject写入,ADC_CLIP读后清零
+//  模块参数注入每次传输的延迟和周期性的NACK/超时/掉电复位
+
+static unsigned int latency_us;
+module_param(latency_us, uint, 0644);
+MODULE_PARM_DESC(latency_us, "delay per transfer in us (slave mode capped at 1000)");
+
+static unsigned int nack_every;
+module_param(nack_every, uint, 0644);
+MODULE_PARM_DESC(nack_every, "NACK every Nth transfer, 0=off");
+
+static unsigned int timeout_every;
+module_param(timeout_every, uint, 0644);
+MODULE_PARM_DESC(timeout_every, "time out every Nth transfer (virtual adapter only), 0=off");
+
+static unsigned int brownout_every;
+module_param(brownout_every, uint, 0644);
+MODULE_PARM_DESC(brownout_every, "reset registers to defaults before every Nth transfer, 0=off");
+
+static bool adapter = true;
+module_param(adapter, bool, 0444);
+MODULE_PARM_DESC(adapter, "register the virtual adapter, codec device and test card");
+
+static char *codec = "adau1977";
+module_param(codec, charp, 0444);
+MODULE_PARM_DESC(codec, "codec on the virtual adapter: adau1977/adau1978/adau1979");
+
+#define ADAU19XX_EMU_ADDR 0x11
+#define ADAU19XX_EMU_SLAVE_MAX_US 1000 //从机回调在中断上下文,延迟上限
+
+#define ADAU19XX_EMU_DEFAULT(reg, name, def, kind) [reg] = def,
+#define ADAU19XX_EMU_FLAGS(reg, name, def, kind) [reg] = ADAU19XX_REG_F_##kind,
+#define ADAU19XX_EMU_NAME(reg, name, def, kind) [reg] = name,
+
+static const u8 adau19xx_emu_defaults[ADAU19XX_NUM_REGS] = {
+    ADAU19XX_REG_TABLE(ADAU19XX_EMU_DEFAULT)
+};
+
+static const u8 adau19xx_emu_flags[ADAU19XX_NUM_REGS] = {
+    ADAU19XX_REG_TABLE(ADAU19XX_EMU_FLAGS)
+};
+
+static const char *const adau19xx_emu_names[ADAU19XX_NUM_REGS] = {
+    ADAU19XX_REG_TABLE(ADAU19XX_EMU_NAME)
+};
+
+static const char *const adau19xx_emu_types[ADAU19XX_TYPE_NUM] = {
+    [ADAU1977] = "adau1977",
+    [ADAU1978] = "adau1978",
+    [ADAU1979] = "adau1979",
+};
+
+struct adau19xx_emu_stats {
+    unsigned long xfers;
+    unsigned long bytes_written;
+    unsigned long bytes_read;
+    unsigned long ignored_writes; //只读或该型号没有的寄存器
+    unsigned long nacks;
+    unsigned long timeouts;
+    unsigned long brownouts;
+    unsigned long soft_resets;
+    unsigned long recoveries;
+};
+
+struct adau19xx_emu {
+    struct device *dev;
+    enum adau19xx_type type;
+    spinlock_t lock;
+    u8 regs[ADAU19XX_NUM_REGS];
+    u8 ptr; //寄存器地址指针,连续读写自动递增
+    bool addr_phase; //写传输的第一个字节是寄存器地址
+    struct adau19xx_emu_stats stats;
+    struct dentry *dir;
+};
+
+static bool adau19xx_emu_present(struct adau19xx_emu *emu, unsigned int reg) {
+    if (reg >= ADAU19XX_NUM_REGS)
+        return false;
+    return emu->type == ADAU1977 || !(adau19xx_emu_flags[reg] & ADAU19XX_REG_F_1977);
+}
+
+static void adau19xx_emu_reset(struct adau19xx_emu *emu) {
+    memcpy(emu->regs, adau19xx_emu_defaults, sizeof (emu->regs));
+}
+
+//一次传输开始(START),返回非0时本次传输失败
+static int adau19xx_emu_start(struct adau19xx_emu *emu) {
+    unsigned long n;
+    unsigned long flags;
+
+    spin_lock_irqsave(&emu->lock, flags);
+    n = ++emu->stats.xfers;
+    emu->addr_phase = true;
+
+    if (brownout_every && n % brownout_every == 0) {
+        adau19xx_emu_reset(emu);
+        emu->stats.brownouts++;
+    }
+    if (timeout_every && n % timeout_every == 0) {
+        emu->stats.timeouts++;
+        spin_unlock_irqrestore(&emu->lock, flags);
+        return -ETIMEDOUT;
+    }
+    if (nack_every && n % nack_every == 0) {
+        emu->stats.nacks++;
+        spin_unlock_irqrestore(&emu->lock, flags);
+        return -ENXIO;
+    }
+    spin_unlock_irqrestore(&emu->lock, flags);
+
+    return 0;
+}
+
+//调用者持有emu->lock
+static void __adau19xx_emu_write_byte(struct adau19xx_emu *emu, u8 val) {
+    unsigned int reg;
+
+    emu->stats.bytes_written++;
+    if (emu->addr_phase) {
+        emu->ptr = val;
+        emu->addr_phase = false;
+        return;
+    }
+
+    reg = emu->ptr++;
+    if (!adau19xx_emu_present(emu, reg) || !(adau19xx_emu_flags[reg] & ADAU19XX_REG_F_W)) {
+        emu->stats.ignored_writes++;
+    } else if (reg == ADAU19XX_REG_POWER && (val & ADAU19XX_POWER_RESET)) {
+        //软件复位:全部寄存器恢复默认值,RESET位自动清零
+        adau19xx_emu_reset(emu);
+        emu->stats.soft_resets++;
+    } else {
+        emu->regs[reg] = val;
+    }
+}
+
+static void adau19xx_emu_write_byte(struct adau19xx_emu *emu, u8 val) {
+    unsigned long flags;
+
+    spin_lock_irqsave(&emu->lock, flags);
+    __adau19xx_emu_write_byte(emu, val);
+    spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+//虚拟适配器上的一条写消息:第一个字节为寄存器地址,整条消息在锁内处理
+static void adau19xx_emu_write_msg(struct adau19xx_emu *emu, const u8 *buf, u16 len) {
+    unsigned long flags;
+    u16 i;
+
+    spin_lock_irqsave(&emu->lock, flags);
+    emu->addr_phase = true;
+    for (i = 0; i < len; i++)
+        __adau19xx_emu_write_byte(emu, buf[i]);
+    spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+static u8 adau19xx_emu_read_byte(struct adau19xx_emu *emu) {
+    unsigned int reg;
+    u8 val = 0;
+    unsigned long flags;
+
+    spin_lock_irqsave(&emu->lock, flags);
+    emu->stats.bytes_read++;
+    reg = emu->ptr++;
+    if (adau19xx_emu_present(emu, reg)) {
+        val = emu->regs[reg];
+        //削波标志锁存到读取为止
+        if (reg == ADAU19XX_REG_ADC_CLIP)
+            emu->regs[reg] = 0;
+    }
+    spin_unlock_irqrestore(&emu->lock, flags);
+
+    return val;
+}
+
+static struct adau19xx_emu *adau19xx_emu_alloc(struct device *dev, enum adau19xx_type type) {
+    struct adau19xx_emu *emu;
+
+    emu = devm_kzalloc(dev, sizeof (*emu), GFP_KERNEL);
+    if (!emu)
+        return NULL;
+
+    emu->dev = dev;
+    emu->type = type;
+    spin_lock_init(&emu->lock);
+    adau19xx_emu_reset(emu);
+
+    return emu;
+}
+
+//------------------------------------------------------------------------
+//debugfs: /sys/kernel/debug/adau19xx-emu-<设备名>/
+//  state   型号、传输统计和全部寄存器
+//  inject  写入"reg val"直接修改寄存器,模拟芯片侧的变化,如 echo 0x19 0x03 > inject 产生削波标志
+
+static int adau19xx_emu_state_show(struct seq_file *s, void *data) {
+    struct adau19xx_emu *emu = s->private;
+    struct adau19xx_emu_stats snap;
+    u8 regs[ADAU19XX_NUM_REGS];
+    unsigned int reg;
+    unsigned long flags;
+
+    spin_lock_irqsave(&emu->lock, flags);
+    snap = emu->stats;
+    memcpy(regs, emu->regs, sizeof (regs));
+    spin_unlock_irqrestore(&emu->lock, flags);
+
+    seq_printf(s, "type: %s\n", adau19xx_emu_types[emu->type]);
+    seq_printf(s, "xfers: %lu bytes_written: %lu bytes_read: %lu ignored_writes: %lu\n",
+            snap.xfers, snap.bytes_written, snap.bytes_read, snap.ignored_writes);
+    seq_printf(s, "nacks: %lu timeouts: %lu recoveries: %lu brownouts: %lu soft_resets: %lu\n",
+            snap.nacks, snap.timeouts, snap.recoveries, snap.brownouts, snap.soft_resets);
+    for (reg = 0; reg < ADAU19XX_NUM_REGS; reg++) {
+        if (!adau19xx_emu_present(emu, reg))
+            continue;
+        seq_printf(s, "0x%02x %-18s 0x%02x\n", reg, adau19xx_emu_names[reg], regs[reg]);
+    }
+
+    return 0;
+}
+
+static int adau19xx_emu_state_open(struct inode *inode, struct file *file) {
+    return single_open(file, adau19xx_emu_state_show, inode->i_private);
+}
+
+static const struct file_operations adau19xx_emu_state_fops = {
+    .owner = THIS_MODULE,
+    .open = adau19xx_emu_state_open,
+    .read = seq_read,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+static ssize_t adau19xx_emu_inject_write(struct file *file, const char __user *user_buf,
+        size_t count, loff_t *ppos) {
+    struct adau19xx_emu *emu = file->private_data;
+    int reg, val;
+    char buf[32];
+    unsigned long flags;
+
+    if (count >= sizeof (buf))
+        return -EINVAL;
+    if (copy_from_user(buf, user_buf, count))
+        return -EFAULT;
+    buf[count] = '\0';
+
+    if (sscanf(buf, "%i %i", &reg, &val) != 2 || reg < 0 || !adau19xx_emu_present(emu, reg) ||
+            val < 0 || val > 0xff)
+        return -EINVAL;
+
+    spin_lock_irqsave(&emu->lock, flags);
+    emu->regs[reg] = val;
+    spin_unlock_irqrestore(&emu->lock, flags);
+
+    return count;
+}
+
+static const struct file_operations adau19xx_emu_inject_fops = {
+    .owner = THIS_MODULE,
+    .open = simple_open,
+    .write = adau19xx_emu_inject_write,
+    .llseek = no_llseek,
+};
+
+static void adau19xx_emu_debugfs_init(struct adau19xx_emu *emu) {
+    char name[64];
+
+    snprintf(name, sizeof (name), "adau19xx-emu-%s", dev_name(emu->dev));
+    emu->dir = debugfs_create_dir(name, NULL);
+    if (IS_ERR_OR_NULL(emu->dir)) {
+        emu->dir = NULL;
+        return;
+    }
+
+    debugfs_create_file("state", 0444, emu->dir, emu, &adau19xx_emu_state_fops);
+    debugfs_create_file("inject", 0200, emu->dir, emu, &adau19xx_emu_inject_fops);
+}
+
+//------------------------------------------------------------------------
+//i2c-slave后端
+
+#if IS_ENABLED(CONFIG_I2C_SLAVE)
+
+static int adau19xx_emu_slave_cb(struct i2c_client *client, enum i2c_slave_event event, u8 *val) {
+    struct adau19xx_emu *emu = i2c_get_clientdata(client);
+
+    switch (event) {
+        case I2C_SLAVE_WRITE_REQUESTED:
+        case I2C_SLAVE_READ_REQUESTED:
+            if (latency_us)
+                udelay(min_t(unsigned int, latency_us, ADAU19XX_EMU_SLAVE_MAX_US));
+            //从机无法模拟超时,按NACK处理
+            if (adau19xx_emu_start(emu))
+                return -EIO;
+            if (event == I2C_SLAVE_READ_REQUESTED)
+                *val = adau19xx_emu_read_byte(emu);
+            break;
+        case I2C_SLAVE_WRITE_RECEIVED:
+            adau19xx_emu_write_byte(emu, *val);
+            break;
+        case I2C_SLAVE_READ_PROCESSED:
+            *val = adau19xx_emu_read_byte(emu);
+            break;
+        case I2C_SLAVE_STOP:
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+static int adau19xx_emu_slave_probe(struct i2c_client *client, const struct i2c_device_id *id) {
+    struct adau19xx_emu *emu;
+    int ret;
+
+    emu = adau19xx_emu_alloc(&client->dev, id->driver_data);
+    if (!emu)
+        return -ENOMEM;
+    i2c_set_clientdata(client, emu);
+
+    ret = i2c_slave_register(client, adau19xx_emu_slave_cb);
+    if (ret)
+        return ret;
+
+    adau19xx_emu_debugfs_init(emu);
+    return 0;
+}
+
+static int adau19xx_emu_slave_remove(struct i2c_client *client) {
+    struct adau19xx_emu *emu = i2c_get_clientdata(client);
+
+    i2c_slave_unregister(client);
+    debugfs_remove_recursive(emu->dir);
+    return 0;
+}
+
+static const struct i2c_device_id adau19xx_emu_slave_id[] = {
+    { "slave-adau1977", ADAU1977},
+    { "slave-adau1978", ADAU1978},
+    { "slave-adau1979", ADAU1979},
+    {}
+};
+MODULE_DEVICE_TABLE(i2c, adau19xx_emu_slave_id);
+
+static struct i2c_driver adau19xx_emu_slave_driver = {
+    .driver = {
+        .name = "adau19xx-emu-slave",
+    },
+    .probe = adau19xx_emu_slave_probe,
+    .remove = adau19xx_emu_slave_remove,
+    .id_table = adau19xx_emu_slave_id,
+};
+
+#endif
+
+//------------------------------------------------------------------------
+//虚拟适配器、codec设备和测试声卡
+
+static struct adau19xx_emu *adau19xx_emu_adap_emu;
+static struct i2c_client *adau19xx_emu_client;
+static struct platform_device *adau19xx_emu_card_pdev;
+static char adau19xx_emu_codec_name[32];
+
+static int adau19xx_emu_master_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num) {
+    struct adau19xx_emu *emu = i2c_get_adapdata(adap);
+    int i, j, ret;
+
+    for (i = 0; i < num; i++) {
+        if (msgs[i].addr != ADAU19XX_EMU_ADDR)
+            return -ENXIO;
+    }
+
+    if (latency_us)
+        usleep_range(latency_us, latency_us + latency_us / 8 + 1);
+
+    //整组消息算一次传输,第一条为写地址,重复START后读
+    ret = adau19xx_emu_start(emu);
+    if (ret)
+        return ret;
+
+    for (i = 0; i < num; i++) {
+        if (msgs[i].flags & I2C_M_RD) {
+            for (j = 0; j < msgs[i].len; j++)
+                msgs[i].buf[j] = adau19xx_emu_read_byte(emu);
+        } else {
+            adau19xx_emu_write_msg(emu, msgs[i].buf, msgs[i].len);
+        }
+    }
+
+    return num;
+}
+
+static u32 adau19xx_emu_functionality(struct i2c_adapter *adap) {
+    return I2C_FUNC_I2C;
+}
+
+static const struct i2c_algorithm adau19xx_emu_algo = {
+    .master_xfer = adau19xx_emu_master_xfer,
+    .functionality = adau19xx_emu_functionality,
+};
+
+//超时注入后驱动会调用i2c_recover_bus,这里只计数
+static int adau19xx_emu_recover_bus(struct i2c_adapter *adap) {
+    struct adau19xx_emu *emu = i2c_get_adapdata(adap);
+    unsigned long flags;
+
+    spin_lock_irqsave(&emu->lock, flags);
+    emu->stats.recoveries++;
+    spin_unlock_irqrestore(&emu->lock, flags);
+    return 0;
+}
+
+static struct i2c_bus_recovery_info adau19xx_emu_recovery = {
+    .recover_bus = adau19xx_emu_recover_bus,
+};
+
+static struct i2c_adapter adau19xx_emu_adapter = {
+    .owner = THIS_MODULE,
+    .name = "adau19xx-emu",
+    .algo = &adau19xx_emu_algo,
+    .bus_recovery_info = &adau19xx_emu_recovery,
+};
+
+//没有设备树,sysclk-src等属性以设备属性提供;LRCLK作参考时钟,不需要MCLK
+static const struct property_entry adau19xx_emu_codec_props[] = {
+    PROPERTY_ENTRY_U32("sysclk-src", ADAU19XX_SYSCLK_SRC_LRCLK),
+    {}
+};
+
+static struct snd_soc_dai_link adau19xx_emu_dai_link = {
+    .name = "adau19xx-emu",
+    .stream_name = "Capture",
+    .cpu_dai_name = "snd-soc-dummy-dai",
+    .platform_name = "snd-soc-dummy",
+    .codec_name = adau19xx_emu_codec_name,
+    .codec_dai_name = "adau19xx-codec",
+    .dai_fmt = SND_SOC_DAIFMT_I2S | SND_SOC_DAIFMT_NB_NF | SND_SOC_DAIFMT_CBS_CFS,
+    .capture_only = 1,
+};
+
+static struct snd_soc_card adau19xx_emu_card = {
+    .name = "adau19xx-emu-card",
+    .owner = THIS_MODULE,
+    .dai_link = &adau19xx_emu_dai_link,
+    .num_links = 1,
+};
+
+//codec未加载时返回-EPROBE_DEFER,加载后自动重试
+static int adau19xx_emu_card_probe(struct platform_device *pdev) {
+    adau19xx_emu_card.dev = &pdev->dev;
+    return devm_snd_soc_register_card(&pdev->dev, &adau19xx_emu_card);
+}
+
+static struct platform_driver adau19xx_emu_card_driver = {
+    .driver = {
+        .name = "adau19xx-emu-card",
+    },
+    .probe = adau19xx_emu_card_probe,
+};
+
+static int adau19xx_emu_adapter_init(void) {
+    struct i2c_board_info info = {
+        .addr = ADAU19XX_EMU_ADDR,
+        .properties = adau19xx_emu_codec_props,
+    };
+    int type, ret;
+
+    type = match_string(adau19xx_emu_types, ADAU19XX_TYPE_NUM, codec);
+    if (type < 0) {
+        pr_err("adau19xx-emu: unknown codec %s\n", codec);
+        return -EINVAL;
+    }
+    strlcpy(info.type, codec, sizeof (info.type));
+
+    ret = i2c_add_adapter(&adau19xx_emu_adapter);
+    if (ret)
+        return ret;
+
+    adau19xx_emu_adap_emu = adau19xx_emu_alloc(&adau19xx_emu_adapter.dev, type);
+    if (!adau19xx_emu_adap_emu) {
+        ret = -ENOMEM;
+        goto err_adapter;
+    }
+    i2c_set_adapdata(&adau19xx_emu_adapter, adau19xx_emu_adap_emu);
+    adau19xx_emu_debugfs_init(adau19xx_emu_adap_emu);
+
+    adau19xx_emu_client = i2c_new_device(&adau19xx_emu_adapter, &info);
+    if (!adau19xx_emu_client) {
+        ret = -ENODEV;
+        goto err_debugfs;
+    }
+    snprintf(adau19xx_emu_codec_name, sizeof (adau19xx_emu_codec_name), "%s", dev_name(&adau19xx_emu_client->dev));
+
+    ret = platform_driver_register(&adau19xx_emu_card_driver);
+    if (ret)
+        goto err_client;
+
+    adau19xx_emu_card_pdev = platform_device_register_simple("adau19xx-emu-card", -1, NULL, 0);
+    if (IS_ERR(adau19xx_emu_card_pdev)) {
+        ret = PTR_ERR(adau19xx_emu_card_pdev);
+        goto err_card_driver;
+    }
+
+    return 0;
+
+err_card_driver:
+    platform_driver_unregister(&adau19xx_emu_card_driver);
+err_client:
+    i2c_unregister_device(adau19xx_emu_client);
+err_debugfs:
+    debugfs_remove_recursive(adau19xx_emu_adap_emu ? adau19xx_emu_adap_emu->dir : NULL);
+err_adapter:
+    i2c_del_adapter(&adau19xx_emu_adapter);
+    return ret;
+}
+
+static void adau19xx_emu_adapter_exit(void) {
+    platform_device_unregister(adau19xx_emu_card_pdev);
+    platform_driver_unregister(&adau19xx_emu_card_driver);
+    i2c_unregister_device(adau19xx_emu_client);
+    debugfs_remove_recursive(adau19xx_emu_adap_emu->dir);
+    i2c_del_adapter(&adau19xx_emu_adapter);
+}
+
+static int __init adau19xx_emu_init(void) {
+    int ret;
+
+#if IS_ENABLED(CONFIG_I2C_SLAVE)
+    ret = i2c_add_driver(&adau19xx_emu_slave_driver);
+    if (ret)
+        return ret;
+#endif
+
+    ret = adapter ? adau19xx_emu_adapter_init() : 0;
+
+#if IS_ENABLED(CONFIG_I2C_SLAVE)
+    if (ret)
+        i2c_del_driver(&adau19xx_emu_slave_driver);
+#endif
+    return ret;
+}
+module_init(adau19xx_emu_init);
+
+static void __exit adau19xx_emu_exit(void) {
+    if (adapter)
+        adau19xx_emu_adapter_exit();
+#if IS_ENABLED(CONFIG_I2C_SLAVE)
+    i2c_del_driver(&adau19xx_emu_slave_driver);
+#endif
+}
+module_exit(adau19xx_emu_exit);
+
+MODULE_DESCRIPTION("ADAU19xx register model for testing without hardware");
+MODULE_AUTHOR("Benjamin Wan<32132145@qq.com>");
+MODULE_LICENSE("GPL");
@@ -1,72 +1,81 @@
 #include <linux/i2c.h>
 #include <linux/mod_devicetable.h>
 #include <linux/module.h>
+#include <linux/of_device.h>
 #include <linux/regmap.h>
 #include <sound/soc.h>
 
 #include "adau19xx.h"
 
-//regmap配置
-static const struct reg_default adau19xx_reg_defaults[] = {
-    { 0x00, 0x00},
-    { 0x01, 0x41},
-    { 0x02, 0x4a},
-    { 0x03, 0x7d},
-    { 0x04, 0x3d},
-    { 0x05, 0x02},
-    { 0x06, 0x00},
-    { 0x07, 0x10},
-    { 0x08, 0x32},
-    { 0x09, 0xf0},
-    { 0x0a, 0xa0},
-    { 0x0b, 0xa0},
-    { 0x0c, 0xa0},
-    { 0x0d, 0xa0},
-    { 0x0e, 0x02},
-    { 0x10, 0x0f},
-    { 0x15, 0x20},
-    { 0x16, 0x00},
-    { 0x17, 0x00},
-    { 0x18, 0x00},
-    { 0x1a, 0x00},
-};
+static int adau19xx_i2c_write(void *context, const void *data, size_t count) {
+    struct i2c_client *i2c = context;
+    int ret;
 
-static bool adau19xx_register_volatile(struct device *dev, unsigned int reg) {
-    /* volatile registers are not cached */
-    switch (reg) {/* 只读的寄存器不做缓存 */
-        case ADAU19XX_REG_STATUS(0):
-        case ADAU19XX_REG_STATUS(1):
-        case ADAU19XX_REG_STATUS(2):
-        case ADAU19XX_REG_STATUS(3):
-        case ADAU19XX_REG_ADC_CLIP:
-            return true; /* always write-through */
-    }
+    ret = i2c_master_send(i2c, data, count);
+    if (ret == count)
+        return 0;
+    return ret < 0 ? ret : -EIO;
+}
 
-    return false;
+static int adau19xx_i2c_read(void *context, const void *reg, size_t reg_size, void *val, size_t val_size) {
+    struct i2c_client *i2c = context;
+    struct i2c_msg xfer[2];
+    int ret;
+
+    xfer[0].addr = i2c->addr;
+    xfer[0].flags = 0;
+    xfer[0].len = reg_size;
+    xfer[0].buf = (void *) reg;
+
+    xfer[1].addr = i2c->addr;
+    xfer[1].flags = I2C_M_RD;
+    xfer[1].len = val_size;
+    xfer[1].buf = val;
+
+    ret = i2c_transfer(i2c->adapter, xfer, 2);
+    if (ret == 2)
+        return 0;
+    return ret < 0 ? ret : -EIO;
 }
 
-static const struct regmap_config adau19xx_regmap_config = {
-    .reg_bits = 8,
-    .val_bits = 8,
-    .max_register = ADAU19XX_REG_DC_HPF_CAL,
-    .volatile_reg = adau19xx_register_volatile,
-    .cache_type = REGCACHE_RBTREE,
-    .reg_defaults = adau19xx_reg_defaults,
-    .num_reg_defaults = ARRAY_SIZE(adau19xx_reg_defaults),
+//适配器未提供bus_recovery_info时返回-EOPNOTSUPP
+static int adau19xx_i2c_recover(void *context) {
+    struct i2c_client *i2c = context;
+
+    return i2c_recover_bus(i2c->adapter);
+}
+
+static const struct adau19xx_bus_ops adau19xx_i2c_bus_ops = {
+    .write = adau19xx_i2c_write,
+    .read = adau19xx_i2c_read,
+    .recover = adau19xx_i2c_recover,
 };
 
 static int adau19xx_i2c_probe(struct i2c_client *i2c,
         const struct i2c_device_id *i2c_id) {
 
+    enum adau19xx_type type;
+    struct adau19xx_bus *bus;
     struct regmap *regmap;
 
-    regmap = devm_regmap_init_i2c(i2c, &adau19xx_regmap_config);
+    //型号优先取设备树compatible的匹配数据
+    if (i2c->dev.of_node)
+        type = (uintptr_t) of_device_get_match_data(&i2c->dev);
+    else
+        type = i2c_id->driver_data;
+
+    //经adau19xx_bus统计每次I2C传输
+    bus = adau19xx_bus_alloc(&i2c->dev, &adau19xx_i2c_bus_ops, i2c, 1);
+    if (!bus)
+        return -ENOMEM;
+
+    regmap = adau19xx_bus_regmap_init(&i2c->dev, bus, adau19xx_variants[type].regmap_config);
 
     if (IS_ERR(regmap)) {
         return PTR_ERR(regmap);
     }
 
-    return adau19xx_probe(i2c, regmap, i2c_id->driver_data);
+    return adau19xx_probe(&i2c->dev, regmap, type, bus, NULL);
 }
 
 static int adau19xx_i2c_remove(struct i2c_client *client) {
@@ -75,14 +84,20 @@ static int adau19xx_i2c_remove(struct i2c_client *client) {
 }
 
 static const struct i2c_device_id adau19xx_i2c_id[] = {
-    { "adau19xx", 0},
+    { "adau19xx", ADAU1977}, //兼容旧dts
+    { "adau1977", ADAU1977},
+    { "adau1978", ADAU1978},
+    { "adau1979", ADAU1979},
     {}
 };
 
 MODULE_DEVICE_TABLE(i2c, adau19xx_i2c_id);
 
 static const struct of_device_id adau19xx_of_match[] = {
-    { .compatible = "adi,adau19xx"},
+    { .compatible = "adi,adau19xx", .data = (void *) ADAU1977},
+    { .compatible = "adi,adau1977", .data = (void *) ADAU1977},
+    { .compatible = "adi,adau1978", .data = (void *) ADAU1978},
+    { .compatible = "adi,adau1979", .data = (void *) ADAU1979},
     {}
 };
 MODULE_DEVICE_TABLE(of, adau19xx_of_match);
@@ -91,13 +106,10 @@ static struct i2c_driver adau19xx_i2c_driver = {.driver =
     {
         .name = "adau19xx-i2c",
         .of_match_table = adau19xx_of_match,
+        .pm = &adau19xx_pm_ops,
     },
     .probe = adau19xx_i2c_probe,
     .remove = adau19xx_i2c_remove,
     .id_table = adau19xx_i2c_id,};
 
 module_i2c_driver(adau19xx_i2c_driver);
-
-MODULE_DESCRIPTION("ASoC ADAU19XX driver");
-MODULE_AUTHOR("Benjamin Wan<32132145@qq.com>");
-MODULE_LICENSE("GPL");
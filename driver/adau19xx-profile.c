@@ -0,0 +1,230 @@
+#include <linux/bitmap.h>
+#include <linux/device.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/regmap.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/string.h>
+#include <sound/control.h>
+#include <sound/soc.h>
+
+#include "adau19xx.h"
+
+//命名寄存器配置:如语音/音乐/测量各一组增益、高通、直流扣除、求和模式等设置
+//来源:dts中adi,profiles子节点,或debugfs的profiles文件
+//通过"Register Profile"控件切换,一次控件写入完成全部寄存器写入
+
+static int adau19xx_profile_cmp(const void *a, const void *b) {
+    const struct reg_sequence *ra = a, *rb = b;
+
+    return (int) ra->reg - (int) rb->reg;
+}
+
+//配置只能改写增益、高通/直流扣除、求和模式和升压设置,返回寄存器中允许改写的位,0=不允许
+//同一寄存器中的静音、直流校准位及电源使能位分别由DAI、校准控件和DAPM控制,配置不能碰
+static unsigned int adau19xx_profile_reg_mask(struct adau1977 *adau19xx, unsigned int reg) {
+    switch (reg) {
+        case ADAU19XX_REG_POST_ADC_GAIN(0) ... ADAU19XX_REG_POST_ADC_GAIN(3):
+        case ADAU19XX_REG_DC_HPF_CAL:
+            return 0xff;
+        case ADAU19XX_REG_MISC_CONTROL:
+            return ADAU19XX_MISC_CONTROL_SUM_MODE_MASK;
+        case ADAU19XX_REG_BOOST:
+            return adau19xx->variant->has_micbias ? 0xff : 0;
+        default:
+            return 0;
+    }
+}
+
+//regs需为devm分配,成功后归配置表所有,失败时由调用者释放;同名配置被替换
+int adau19xx_profile_set(struct adau1977 *adau19xx, const char *name,
+        struct reg_sequence *regs, unsigned int num) {
+    struct adau19xx_profile *p = NULL;
+    unsigned int i, mask;
+
+    if (!num || !name[0] || strlen(name) >= ADAU19XX_PROFILE_NAME_LEN)
+        return -EINVAL;
+
+    for (i = 0; i < num; i++) {
+        mask = adau19xx_profile_reg_mask(adau19xx, regs[i].reg);
+        if (!mask || (regs[i].def & ~mask)) {
+            dev_err(adau19xx->dev, "profile %s: invalid entry 0x%x=0x%x\n", name, regs[i].reg, regs[i].def);
+            return -EINVAL;
+        }
+    }
+
+    //按地址排序,便于合并连续寄存器
+    sort(regs, num, sizeof (*regs), adau19xx_profile_cmp, NULL);
+
+    mutex_lock(&adau19xx->lock);
+    for (i = 0; i < adau19xx->num_profiles; i++) {
+        if (!strcmp(adau19xx->profiles[i].name, name)) {
+            p = &adau19xx->profiles[i];
+            devm_kfree(adau19xx->dev, p->regs);
+            break;
+        }
+    }
+
+    if (!p) {
+        //控件注册后条目数和名称固定,控件的info/get不持锁读取profile_enum和profile_texts
+        if (adau19xx->profiles_fixed || adau19xx->num_profiles >= ADAU19XX_MAX_PROFILES) {
+            mutex_unlock(&adau19xx->lock);
+            return adau19xx->profiles_fixed ? -EBUSY : -ENOSPC;
+        }
+        p = &adau19xx->profiles[adau19xx->num_profiles];
+        strlcpy(p->name, name, sizeof (p->name));
+        adau19xx->profile_texts[adau19xx->num_profiles + 1] = p->name;
+        adau19xx->num_profiles++;
+        adau19xx->profile_enum.items = adau19xx->num_profiles + 1;
+    }
+    p->regs = regs;
+    p->num_regs = num;
+    mutex_unlock(&adau19xx->lock);
+
+    return 0;
+}
+EXPORT_SYMBOL_GPL(adau19xx_profile_set);
+
+//adi,profiles {
+//    speech { adi,regs = <0x0a 0x90 0x1a 0x0f>; };
+//    music { adi,regs = <0x0a 0xa0 0x1a 0x00>; };
+//};
+int adau19xx_profile_of_init(struct adau1977 *adau19xx) {
+    struct device_node *np, *child;
+    struct reg_sequence *regs;
+    unsigned int num;
+    int ret = 0;
+
+    adau19xx->profile_texts[0] = "None";
+    adau19xx->profile_enum.reg = SND_SOC_NOPM;
+    adau19xx->profile_enum.items = 1;
+    adau19xx->profile_enum.texts = adau19xx->profile_texts;
+
+    np = of_get_child_by_name(adau19xx->dev->of_node, "adi,profiles");
+    if (!np)
+        return 0;
+
+    for_each_child_of_node(np, child) {
+        ret = adau19xx_of_read_reg_seq(adau19xx, child, "adi,regs", &regs, &num);
+        if (!ret)
+            ret = adau19xx_profile_set(adau19xx, child->name, regs, num);
+        if (ret) {
+            dev_err(adau19xx->dev, "failed to load profile %s: %d\n", child->name, ret);
+            of_node_put(child);
+            break;
+        }
+    }
+    of_node_put(np);
+
+    return ret;
+}
+EXPORT_SYMBOL_GPL(adau19xx_profile_of_init);
+
+//整字节归配置所有的寄存器,地址连续的合并为一次连续写入;
+//只允许改写部分位的寄存器用regmap_update_bits,在regmap锁内读改写,不会覆盖其他路径同时修改的位
+static int adau19xx_profile_write(struct adau1977 *adau19xx, const struct adau19xx_profile *p,
+        unsigned long *touched) {
+    u8 run[ADAU19XX_NUM_REGS];
+    unsigned int i, n, mask;
+    int ret;
+
+    for (i = 0; i < p->num_regs; i += n) {
+        mask = adau19xx_profile_reg_mask(adau19xx, p->regs[i].reg);
+        set_bit(p->regs[i].reg, touched);
+        if (mask != 0xff) {
+            ret = regmap_update_bits(adau19xx->regmap, p->regs[i].reg, mask, p->regs[i].def);
+            n = 1;
+        } else {
+            run[0] = p->regs[i].def;
+            for (n = 1; i + n < p->num_regs; n++) {
+                if (p->regs[i + n].reg != p->regs[i].reg + n ||
+                        adau19xx_profile_reg_mask(adau19xx, p->regs[i + n].reg) != 0xff)
+                    break;
+                run[n] = p->regs[i + n].def;
+                set_bit(p->regs[i + n].reg, touched);
+            }
+            ret = regmap_bulk_write(adau19xx->regmap, p->regs[i].reg, run, n);
+        }
+        if (ret)
+            return ret;
+    }
+
+    return 0;
+}
+
+//通知寄存器被配置修改过的控件,alsamixer等界面随之刷新
+//控件写入期间ALSA已持有controls_rwsem读锁,遍历控件链表是安全的
+static void adau19xx_profile_notify(struct snd_soc_codec *codec, const unsigned long *touched) {
+    struct snd_card *card = codec->component.card->snd_card;
+    struct snd_kcontrol *kctl;
+    unsigned int reg;
+
+    list_for_each_entry(kctl, &card->controls, list) {
+        if (kctl->private_data != &codec->component)
+            continue;
+
+        if (kctl->info == snd_soc_info_volsw)
+            reg = ((struct soc_mixer_control *) kctl->private_value)->reg;
+        else if (kctl->info == snd_soc_info_enum_double)
+            reg = ((struct soc_enum *) kctl->private_value)->reg;
+        else
+            continue;
+
+        if (reg < ADAU19XX_NUM_REGS && test_bit(reg, touched))
+            snd_ctl_notify(card, SNDRV_CTL_EVENT_MASK_VALUE, &kctl->id);
+    }
+}
+
+static int adau19xx_profile_get(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol) {
+    struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+    struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(codec);
+
+    ucontrol->value.enumerated.item[0] = adau19xx->cur_profile;
+    return 0;
+}
+
+static int adau19xx_profile_put(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol) {
+    struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+    struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(codec);
+    unsigned int idx = ucontrol->value.enumerated.item[0];
+    DECLARE_BITMAP(touched, ADAU19XX_NUM_REGS);
+    int ret = 0;
+
+    bitmap_zero(touched, ADAU19XX_NUM_REGS);
+
+    mutex_lock(&adau19xx->lock);
+    if (idx > adau19xx->num_profiles) {
+        ret = -EINVAL;
+    } else if (idx == 0) {
+        //None:只清除标记,不改寄存器
+        ret = adau19xx->cur_profile != 0;
+        adau19xx->cur_profile = 0;
+    } else {
+        ret = adau19xx_profile_write(adau19xx, &adau19xx->profiles[idx - 1], touched);
+        if (ret == 0) {
+            adau19xx->cur_profile = idx;
+            ret = 1;
+        }
+    }
+    mutex_unlock(&adau19xx->lock);
+
+    if (ret == 1)
+        adau19xx_profile_notify(codec, touched);
+
+    return ret;
+}
+
+//控件按此时的配置个数注册,之后只能替换已有配置的寄存器,不能新增
+int adau19xx_profile_add_controls(struct snd_soc_codec *codec) {
+    struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(codec);
+    const struct snd_kcontrol_new control =
+        SOC_ENUM_EXT("Register Profile", adau19xx->profile_enum, adau19xx_profile_get, adau19xx_profile_put);
+
+    mutex_lock(&adau19xx->lock);
+    adau19xx->profiles_fixed = true;
+    mutex_unlock(&adau19xx->lock);
+
+    return snd_soc_add_codec_controls(codec, &control, 1);
+}
+EXPORT_SYMBOL_GPL(adau19xx_profile_add_controls);
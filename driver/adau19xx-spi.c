@@ -0,0 +1,106 @@
+#include <linux/mod_devicetable.h>
+#include <linux/module.h>
+#include <linux/of_device.h>
+#include <linux/regmap.h>
+#include <linux/spi/spi.h>
+#include <sound/soc.h>
+
+#include "adau19xx.h"
+
+//SPI控制:第一个字节为芯片地址和读写位,第二个字节为寄存器地址
+#define ADAU19XX_SPI_READ_FLAG 0x01
+
+static void adau19xx_spi_switch_mode(struct device *dev) {
+    struct spi_device *spi = to_spi_device(dev);
+
+    //CLATCH连续拉低三次后芯片切换到SPI模式,这里用三次空读实现
+    spi_w8r8(spi, 0x00);
+    spi_w8r8(spi, 0x00);
+    spi_w8r8(spi, 0x00);
+}
+
+static int adau19xx_spi_write(void *context, const void *data, size_t count) {
+    struct spi_device *spi = context;
+
+    return spi_write(spi, data, count);
+}
+
+static int adau19xx_spi_read(void *context, const void *reg, size_t reg_size, void *val, size_t val_size) {
+    struct spi_device *spi = context;
+
+    return spi_write_then_read(spi, reg, reg_size, val, val_size);
+}
+
+static const struct adau19xx_bus_ops adau19xx_spi_bus_ops = {
+    .write = adau19xx_spi_write,
+    .read = adau19xx_spi_read,
+};
+
+static int adau19xx_spi_probe(struct spi_device *spi) {
+    const struct spi_device_id *id = spi_get_device_id(spi);
+    struct regmap_config config;
+    enum adau19xx_type type;
+    struct adau19xx_bus *bus;
+    struct regmap *regmap;
+
+    if (spi->dev.of_node)
+        type = (uintptr_t) of_device_get_match_data(&spi->dev);
+    else if (id)
+        type = id->driver_data;
+    else
+        return -EINVAL;
+
+    bus = adau19xx_bus_alloc(&spi->dev, &adau19xx_spi_bus_ops, spi, 2);
+    if (!bus)
+        return -ENOMEM;
+    bus->read_flag_mask = ADAU19XX_SPI_READ_FLAG;
+
+    config = *adau19xx_variants[type].regmap_config;
+    config.reg_bits = 16;
+    config.read_flag_mask = ADAU19XX_SPI_READ_FLAG;
+
+    regmap = adau19xx_bus_regmap_init(&spi->dev, bus, &config);
+    if (IS_ERR(regmap))
+        return PTR_ERR(regmap);
+
+    return adau19xx_probe(&spi->dev, regmap, type, bus, adau19xx_spi_switch_mode);
+}
+
+static int adau19xx_spi_remove(struct spi_device *spi) {
+    snd_soc_unregister_codec(&spi->dev);
+    return 0;
+}
+
+static const struct spi_device_id adau19xx_spi_ids[] = {
+    { "adau19xx", ADAU1977},
+    { "adau1977", ADAU1977},
+    { "adau1978", ADAU1978},
+    { "adau1979", ADAU1979},
+    {}
+};
+MODULE_DEVICE_TABLE(spi, adau19xx_spi_ids);
+
+static const struct of_device_id adau19xx_spi_of_match[] = {
+    { .compatible = "adi,adau19xx", .data = (void *) ADAU1977},
+    { .compatible = "adi,adau1977", .data = (void *) ADAU1977},
+    { .compatible = "adi,adau1978", .data = (void *) ADAU1978},
+    { .compatible = "adi,adau1979", .data = (void *) ADAU1979},
+    {}
+};
+MODULE_DEVICE_TABLE(of, adau19xx_spi_of_match);
+
+static struct spi_driver adau19xx_spi_driver = {
+    .driver = {
+        .name = "adau19xx-spi",
+        .of_match_table = adau19xx_spi_of_match,
+        .pm = &adau19xx_pm_ops,
+    },
+    .probe = adau19xx_spi_probe,
+    .remove = adau19xx_spi_remove,
+    .id_table = adau19xx_spi_ids,
+};
+module_spi_driver(adau19xx_spi_driver);
+
+MODULE_DESCRIPTION("ASoC ADAU19XX SPI driver");
+MODULE_AUTHOR("Benjamin Wan<32132145@qq.com>");
+MODULE_LICENSE("GPL");
@@ -1,10 +1,12 @@
 #include <linux/delay.h>
 #include <linux/device.h>
 #include <linux/gpio/consumer.h>
-#include <linux/i2c.h>
 #include <linux/init.h>
+#include <linux/iopoll.h>
 #include <linux/module.h>
 #include <linux/moduleparam.h>
+#include <linux/of.h>
+#include <linux/property.h>
 #include <linux/regmap.h>
 #include <linux/slab.h>
 
@@ -17,6 +19,106 @@
 
 #include "adau19xx.h"
 
+//regmap配置,I2C与SPI共用,全部由adau19xx.h中的寄存器描述表生成
+#define ADAU19XX_REG_FLAGS(reg, name, def, kind) [reg] = ADAU19XX_REG_F_##kind,
+#define ADAU19XX_REG_NAME(reg, name, def, kind) [reg] = name,
+
+const u8 adau19xx_reg_flags[ADAU19XX_NUM_REGS] = {
+    ADAU19XX_REG_TABLE(ADAU19XX_REG_FLAGS)
+};
+EXPORT_SYMBOL_GPL(adau19xx_reg_flags);
+
+static const char *const adau19xx_reg_names[ADAU19XX_NUM_REGS] = {
+    ADAU19XX_REG_TABLE(ADAU19XX_REG_NAME)
+};
+
+const char *adau19xx_reg_name(unsigned int reg) {
+    if (reg >= ADAU19XX_NUM_REGS)
+        return "";
+    return adau19xx_reg_names[reg];
+}
+EXPORT_SYMBOL_GPL(adau19xx_reg_name);
+
+//只有RW类寄存器有可靠的默认值,regcache_sync跳过与默认值相同的寄存器
+#define ADAU1977_REG_DEFAULT(reg, name, def, kind) ADAU1977_REG_DEFAULT_##kind(reg, def)
+#define ADAU1977_REG_DEFAULT_RW(reg, def) { reg, def },
+#define ADAU1977_REG_DEFAULT_RW77(reg, def) { reg, def },
+#define ADAU1977_REG_DEFAULT_RO(reg, def)
+#define ADAU1977_REG_DEFAULT_RO77(reg, def)
+#define ADAU1977_REG_DEFAULT_RSV(reg, def)
+
+//ADAU1978/1979没有升压、MICBIAS和诊断功能,对应寄存器不缓存也不访问
+#define ADAU1978_REG_DEFAULT(reg, name, def, kind) ADAU1978_REG_DEFAULT_##kind(reg, def)
+#define ADAU1978_REG_DEFAULT_RW(reg, def) { reg, def },
+#define ADAU1978_REG_DEFAULT_RW77(reg, def)
+#define ADAU1978_REG_DEFAULT_RO(reg, def)
+#define ADAU1978_REG_DEFAULT_RO77(reg, def)
+#define ADAU1978_REG_DEFAULT_RSV(reg, def)
+
+static const struct reg_default adau1977_reg_defaults[] = {
+    ADAU19XX_REG_TABLE(ADAU1977_REG_DEFAULT)
+};
+
+static const struct reg_default adau1978_reg_defaults[] = {
+    ADAU19XX_REG_TABLE(ADAU1978_REG_DEFAULT)
+};
+
+//描述表自检:每个地址恰好一行、地址和默认值不越界
+//行数等于寄存器数且各行BIT(地址)之和为全1时,不可能有重复地址(重复会进位,需要更多行才能凑满)
+#define ADAU19XX_REG_COUNT(reg, name, def, kind) + 1
+#define ADAU19XX_REG_VALID(reg, name, def, kind) && (reg) < ADAU19XX_NUM_REGS && (def) <= 0xff
+#define ADAU19XX_REG_BIT(reg, name, def, kind) + BIT_ULL(reg)
+
+static inline void adau19xx_reg_table_check(void) {
+    BUILD_BUG_ON((0 ADAU19XX_REG_TABLE(ADAU19XX_REG_COUNT)) != ADAU19XX_NUM_REGS);
+    BUILD_BUG_ON(!(1 ADAU19XX_REG_TABLE(ADAU19XX_REG_VALID)));
+    BUILD_BUG_ON((0 ADAU19XX_REG_TABLE(ADAU19XX_REG_BIT)) != BIT_ULL(ADAU19XX_NUM_REGS) - 1);
+}
+
+static bool adau1977_readable_reg(struct device *dev, unsigned int reg) {
+    return reg < ADAU19XX_NUM_REGS && (adau19xx_reg_flags[reg] & ADAU19XX_REG_F_R);
+}
+
+static bool adau1977_writeable_reg(struct device *dev, unsigned int reg) {
+    return reg < ADAU19XX_NUM_REGS && (adau19xx_reg_flags[reg] & ADAU19XX_REG_F_W);
+}
+
+static bool adau1978_readable_reg(struct device *dev, unsigned int reg) {
+    return adau1977_readable_reg(dev, reg) && !(adau19xx_reg_flags[reg] & ADAU19XX_REG_F_1977);
+}
+
+static bool adau1978_writeable_reg(struct device *dev, unsigned int reg) {
+    return adau1977_writeable_reg(dev, reg) && !(adau19xx_reg_flags[reg] & ADAU19XX_REG_F_1977);
+}
+
+static bool adau19xx_volatile_reg(struct device *dev, unsigned int reg) {
+    return reg < ADAU19XX_NUM_REGS && (adau19xx_reg_flags[reg] & ADAU19XX_REG_F_VOLATILE);
+}
+
+static const struct regmap_config adau1977_regmap_config = {
+    .reg_bits = 8,
+    .val_bits = 8,
+    .max_register = ADAU19XX_REG_DC_HPF_CAL,
+    .readable_reg = adau1977_readable_reg,
+    .writeable_reg = adau1977_writeable_reg,
+    .volatile_reg = adau19xx_volatile_reg,
+    .cache_type = REGCACHE_RBTREE,
+    .reg_defaults = adau1977_reg_defaults,
+    .num_reg_defaults = ARRAY_SIZE(adau1977_reg_defaults),
+};
+
+static const struct regmap_config adau1978_regmap_config = {
+    .reg_bits = 8,
+    .val_bits = 8,
+    .max_register = ADAU19XX_REG_DC_HPF_CAL,
+    .readable_reg = adau1978_readable_reg,
+    .writeable_reg = adau1978_writeable_reg,
+    .volatile_reg = adau19xx_volatile_reg,
+    .cache_type = REGCACHE_RBTREE,
+    .reg_defaults = adau1978_reg_defaults,
+    .num_reg_defaults = ARRAY_SIZE(adau1978_reg_defaults),
+};
+
 static const unsigned int adau19xx_rates[] = {
     8000, 16000, 32000, 64000, 128000,
     11025, 22050, 44100, 88200, 172400,
@@ -79,9 +181,7 @@ static const struct soc_enum adau19xx_enum[] = {
     SOC_ENUM_SINGLE(ADAU19XX_REG_BOOST, 3, 2, adau19xx_common_en_texts), //过压故障保护 0=disable 1=enable
     SOC_ENUM_SINGLE(ADAU19XX_REG_BOOST, 1, 2, adau19xx_common_en_texts), //过流故障保护 0=disable 1=enable
 
-    SOC_ENUM_SINGLE(ADAU19XX_REG_MICBIAS, 2, 2, adau19xx_common_onoff_texts), //Boost使能 0=off 1=on
     SOC_ENUM_SINGLE(ADAU19XX_REG_MICBIAS, 4, 9, adau19xx_micbias_volts_texts), //MICBIAS输出电压
-    SOC_ENUM_SINGLE(ADAU19XX_REG_MICBIAS, 3, 2, adau19xx_common_onoff_texts), //Micbias使能 0=off 1=on
     SOC_ENUM_SINGLE(ADAU19XX_REG_MICBIAS, 0, 2, adau19xx_boost_recovery_mode_texts), //升压故障恢复模式 0=自动故障恢复 1=手动故障恢复
 
     SOC_ENUM_SINGLE(ADAU19XX_REG_SAI_OVERTEMP, 7, 2, adau19xx_common_onoff_texts), //通道4串行输出驱动使能
@@ -97,6 +197,94 @@ static const struct soc_enum adau19xx_enum[] = {
 };
 
 
+//读硬件中的DC_CAL位:返回0表示校准完成,1表示进行中,负数为总线错误
+static int adau19xx_dc_cal_busy(struct adau1977 *adau19xx) {
+    u8 val;
+    int ret;
+
+    ret = adau19xx_hw_bulk_read(adau19xx, ADAU19XX_REG_MISC_CONTROL, &val, 1);
+    if (ret)
+        return ret;
+    return !!(val & ADAU19XX_MISC_CONTROL_DC_CAL);
+}
+
+//直流校准:DC_CAL位只写硬件,缓存中始终为0,regcache_sync时不会重复触发校准
+//置位和轮询都绕过缓存单独访问硬件,不打开全局cache_bypass,校准期间其他控件的写入照常进缓存
+static int adau19xx_dc_calibrate(struct adau1977 *adau19xx) {
+#ifdef CONFIG_ADAU19XX_DEBUG
+    dev_info(adau19xx->dev, "adau19xx:%s \n", __FUNCTION__);
+#endif
+    struct reg_sequence seq = { ADAU19XX_REG_MISC_CONTROL };
+    unsigned int val;
+    int busy, ret;
+
+    //其他位取缓存中的值,缓存中DC_CAL始终为0
+    ret = regmap_read(adau19xx->regmap, ADAU19XX_REG_MISC_CONTROL, &val);
+    if (ret == 0) {
+        seq.def = val | ADAU19XX_MISC_CONTROL_DC_CAL;
+        ret = regmap_multi_reg_write_bypassed(adau19xx->regmap, &seq, 1);
+    }
+    if (ret == 0) {
+        ret = readx_poll_timeout(adau19xx_dc_cal_busy, adau19xx, busy, busy <= 0,
+                ADAU19XX_DC_CAL_POLL_US, ADAU19XX_DC_CAL_TIMEOUT_US);
+        if (ret == 0 && busy < 0)
+            ret = busy;
+        if (ret) {
+            //超时则手动清零,避免校准位残留
+            seq.def = val;
+            regmap_multi_reg_write_bypassed(adau19xx->regmap, &seq, 1);
+        }
+    }
+    adau19xx->dc_cal_pending = false;
+    if (ret) {
+        dev_err(adau19xx->dev, "dc calibration failed: %d\n", ret);
+        adau19xx->dc_cal_done = false;
+        return ret;
+    }
+
+    adau19xx->dc_cal_done = true;
+    return 0;
+}
+
+//复位后第一次打开音频流时补做校准,此时PLL已锁定;失败则清除标记,音频流照常打开
+static void adau19xx_dc_cal_restore(struct adau1977 *adau19xx) {
+    mutex_lock(&adau19xx->lock);
+    if (adau19xx->dc_cal_pending && adau19xx->enabled)
+        adau19xx_dc_calibrate(adau19xx);
+    mutex_unlock(&adau19xx->lock);
+}
+
+static int adau19xx_dc_cal_get(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol) {
+    struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+    struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(codec);
+
+    ucontrol->value.integer.value[0] = adau19xx->dc_cal_done;
+    return 0;
+}
+
+//写1立即执行一次校准并等待完成,写0仅清除标记
+static int adau19xx_dc_cal_put(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol) {
+    struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+    struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(codec);
+    int ret;
+
+    mutex_lock(&adau19xx->lock);
+    if (!ucontrol->value.integer.value[0]) {
+        ret = adau19xx->dc_cal_done;
+        adau19xx->dc_cal_done = false;
+        adau19xx->dc_cal_pending = false;
+    } else if (!adau19xx->enabled) {
+        ret = -EBUSY;
+    } else {
+        ret = adau19xx_dc_calibrate(adau19xx);
+        if (ret == 0)
+            ret = 1;
+    }
+    mutex_unlock(&adau19xx->lock);
+
+    return ret;
+}
+
 //后置ADC增益控制寄存器 范围0~255(-35.635dB~60dB 静音)
 static const DECLARE_TLV_DB_MINMAX_MUTE(adau19xx_adc_gain, -3562, 6000);
 
@@ -124,10 +312,22 @@ static const struct snd_kcontrol_new adau19xx_snd_controls[] = {
     ADAU_DC_SUB_SWITCH(2),
     ADAU_DC_SUB_SWITCH(3),
     ADAU_DC_SUB_SWITCH(4),
+    //0x0E 触发直流校准,结果保存在芯片内,配合DC Subtraction使用
+    SOC_SINGLE_BOOL_EXT("DC Calibration", 0, adau19xx_dc_cal_get, adau19xx_dc_cal_put),
 
     //0x0E
     SOC_ENUM("Sum Mode", adau19xx_enum[0]), //通道求和模式控制
 
+    //0x09
+    SOC_ENUM("Ch4 Drive", adau19xx_enum[7]), //通道4串行输出驱动使能
+    SOC_ENUM("Ch3 Drive", adau19xx_enum[8]), //通道3串行输出驱动使能
+    SOC_ENUM("Ch2 Drive", adau19xx_enum[9]), //通道2串行输出驱动使能
+    SOC_ENUM("Ch1 Drive", adau19xx_enum[10]), //通道1串行输出驱动使能
+    SOC_ENUM("Unused Outputs Status", adau19xx_enum[11]), //让不用的SAI通道处于三台还是积极驱动这些数据时隙
+};
+
+//仅ADAU1977:升压转换器、MICBIAS和诊断
+static const struct snd_kcontrol_new adau1977_snd_controls[] = {
     //0x02
     SOC_ENUM("Boost Sample Rate", adau19xx_enum[1]), //升压开关频率的采样速率控制
     SOC_ENUM("Boost Switch Freq", adau19xx_enum[2]), //升压调节器开关频率
@@ -135,25 +335,50 @@ static const struct snd_kcontrol_new adau19xx_snd_controls[] = {
     SOC_ENUM("Boost Over Current Protect", adau19xx_enum[4]), //过流故障保护 0=disable 1=enable
 
     //0x03
-    SOC_ENUM("Boost Enable", adau19xx_enum[5]), //Boost开关
-    SOC_ENUM("Micbias Voltage", adau19xx_enum[6]), //MICBIAS输出电压
-    SOC_ENUM("Micbias Enable", adau19xx_enum[7]), //MICBIAS开关
-    SOC_ENUM("Boost Recovery Mode", adau19xx_enum[8]), //升压故障恢复模式 0=自动故障恢复 1=手动故障恢复
-
-    //0x09
-    SOC_ENUM("Ch4 Drive", adau19xx_enum[9]), //通道4串行输出驱动使能
-    SOC_ENUM("Ch3 Drive", adau19xx_enum[10]), //通道3串行输出驱动使能
-    SOC_ENUM("Ch2 Drive", adau19xx_enum[11]), //通道2串行输出驱动使能
-    SOC_ENUM("Ch1 Drive", adau19xx_enum[12]), //通道1串行输出驱动使能
-    SOC_ENUM("Unused Outputs Status", adau19xx_enum[13]), //让不用的SAI通道处于三台还是积极驱动这些数据时隙
+    //Boost和MICBIAS开关由DAPM按录音流自动控制
+    SOC_ENUM("Micbias Voltage", adau19xx_enum[5]), //MICBIAS输出电压
+    SOC_ENUM("Boost Recovery Mode", adau19xx_enum[6]), //升压故障恢复模式 0=自动故障恢复 1=手动故障恢复
 
     //0x10
-    SOC_ENUM("Ch4 Diagnostics", adau19xx_enum[14]), //通道4诊断使能
-    SOC_ENUM("Ch3 Diagnostics", adau19xx_enum[15]), //通道3诊断使能
-    SOC_ENUM("Ch2 Diagnostics", adau19xx_enum[16]), //通道2诊断使能
-    SOC_ENUM("Ch1 Diagnostics", adau19xx_enum[17]), //通道1诊断使能
+    SOC_ENUM("Ch4 Diagnostics", adau19xx_enum[12]), //通道4诊断使能
+    SOC_ENUM("Ch3 Diagnostics", adau19xx_enum[13]), //通道3诊断使能
+    SOC_ENUM("Ch2 Diagnostics", adau19xx_enum[14]), //通道2诊断使能
+    SOC_ENUM("Ch1 Diagnostics", adau19xx_enum[15]), //通道1诊断使能
 };
 
+//录音时先开Boost再开MICBIAS,关闭顺序相反.MCLK模式下充电时间与BIAS_ON中等待PLL的60ms重叠
+static int adau19xx_micbias_event(struct snd_soc_dapm_widget *w,
+        struct snd_kcontrol *kcontrol, int event) {
+    struct snd_soc_codec *codec = snd_soc_dapm_to_codec(w->dapm);
+    struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(codec);
+
+    adau19xx_res_set(adau19xx, ADAU19XX_RES_MICBIAS, SND_SOC_DAPM_EVENT_ON(event));
+
+    if (SND_SOC_DAPM_EVENT_ON(event) && adau19xx->clk_src != ADAU19XX_SYSCLK_SRC_MCLK)
+        msleep(ADAU19XX_MICBIAS_SETTLE_MS);
+
+    return 0;
+}
+
+static int adau19xx_boost_event(struct snd_soc_dapm_widget *w,
+        struct snd_kcontrol *kcontrol, int event) {
+    struct snd_soc_codec *codec = snd_soc_dapm_to_codec(w->dapm);
+    struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(codec);
+
+    adau19xx_res_set(adau19xx, ADAU19XX_RES_BOOST, SND_SOC_DAPM_EVENT_ON(event));
+    return 0;
+}
+
+//统计同时上电的ADC数
+static int adau19xx_adc_event(struct snd_soc_dapm_widget *w,
+        struct snd_kcontrol *kcontrol, int event) {
+    struct snd_soc_codec *codec = snd_soc_dapm_to_codec(w->dapm);
+    struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(codec);
+
+    adau19xx_res_set(adau19xx, ADAU19XX_RES_ADCS, SND_SOC_DAPM_EVENT_ON(event) ? 1 : -1);
+    return 0;
+}
+
 static const struct snd_soc_dapm_widget adau19xx_dapm_widgets[] = {
     //input widgets
     SND_SOC_DAPM_INPUT("AIN1"),
@@ -163,14 +388,26 @@ static const struct snd_soc_dapm_widget adau19xx_dapm_widgets[] = {
 
     //模块电源控制和串行端口控制寄存器
     SND_SOC_DAPM_SUPPLY("Vref", ADAU19XX_REG_BLOCK_POWER_SAI, 4, 0, NULL, 0), //基准电压使能
-    SND_SOC_DAPM_ADC("ADC1", "Capture", ADAU19XX_REG_BLOCK_POWER_SAI, 0, 0), //ADC通道1使能
-    SND_SOC_DAPM_ADC("ADC2", "Capture", ADAU19XX_REG_BLOCK_POWER_SAI, 1, 0), //ADC通道2使能
-    SND_SOC_DAPM_ADC("ADC3", "Capture", ADAU19XX_REG_BLOCK_POWER_SAI, 2, 0), //ADC通道3使能
-    SND_SOC_DAPM_ADC("ADC4", "Capture", ADAU19XX_REG_BLOCK_POWER_SAI, 3, 0), //ADC通道4使能
+    SND_SOC_DAPM_ADC_E("ADC1", "Capture", ADAU19XX_REG_BLOCK_POWER_SAI, 0, 0,
+            adau19xx_adc_event, SND_SOC_DAPM_POST_PMU | SND_SOC_DAPM_PRE_PMD), //ADC通道1使能
+    SND_SOC_DAPM_ADC_E("ADC2", "Capture", ADAU19XX_REG_BLOCK_POWER_SAI, 1, 0,
+            adau19xx_adc_event, SND_SOC_DAPM_POST_PMU | SND_SOC_DAPM_PRE_PMD), //ADC通道2使能
+    SND_SOC_DAPM_ADC_E("ADC3", "Capture", ADAU19XX_REG_BLOCK_POWER_SAI, 2, 0,
+            adau19xx_adc_event, SND_SOC_DAPM_POST_PMU | SND_SOC_DAPM_PRE_PMD), //ADC通道3使能
+    SND_SOC_DAPM_ADC_E("ADC4", "Capture", ADAU19XX_REG_BLOCK_POWER_SAI, 3, 0,
+            adau19xx_adc_event, SND_SOC_DAPM_POST_PMU | SND_SOC_DAPM_PRE_PMD), //ADC通道4使能
 
     SND_SOC_DAPM_OUTPUT("VREF"),
 };
 
+//仅ADAU1977:0x03 麦克风偏置及其升压电源
+static const struct snd_soc_dapm_widget adau1977_dapm_widgets[] = {
+    SND_SOC_DAPM_SUPPLY_S("Boost", 0, ADAU19XX_REG_MICBIAS, ADAU19XX_MICBIAS_BOOST_EN_SHIFT, 0,
+            adau19xx_boost_event, SND_SOC_DAPM_POST_PMU | SND_SOC_DAPM_PRE_PMD),
+    SND_SOC_DAPM_SUPPLY_S("MICBIAS", 1, ADAU19XX_REG_MICBIAS, ADAU19XX_MICBIAS_MB_EN_SHIFT, 0,
+            adau19xx_micbias_event, SND_SOC_DAPM_POST_PMU | SND_SOC_DAPM_PRE_PMD),
+};
+
 static const struct snd_soc_dapm_route adau19xx_dapm_routes[] = {
     { "ADC1", NULL, "AIN1"},
     { "ADC2", NULL, "AIN2"},
@@ -185,21 +422,29 @@ static const struct snd_soc_dapm_route adau19xx_dapm_routes[] = {
     { "VREF", NULL, "Vref"},
 };
 
-static int adau19xx_reset(struct adau1977 *adau19xx) {
-#ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("adau19xx:%s \n", __FUNCTION__);
-#endif
-    int ret;
-    regcache_cache_bypass(adau19xx->regmap, true);
-    ret = regmap_write(adau19xx->regmap, ADAU19XX_REG_POWER, ADAU19XX_POWER_RESET); //软件复位
-    regcache_cache_bypass(adau19xx->regmap, false);
-    if (ret) {
-#ifdef CONFIG_ADAU19XX_DEBUG
-        pr_err("soft reset error\n");
-#endif
-        return ret;
-    }
-    return ret;
+static const struct snd_soc_dapm_route adau1977_dapm_routes[] = {
+    { "MICBIAS", NULL, "Boost"},
+};
+
+//输入接麦克风时,任一通道录音都需要MICBIAS;dts中adi,micbias-disable可去掉这些路径
+static const struct snd_soc_dapm_route adau1977_micbias_routes[] = {
+    { "AIN1", NULL, "MICBIAS"},
+    { "AIN2", NULL, "MICBIAS"},
+    { "AIN3", NULL, "MICBIAS"},
+    { "AIN4", NULL, "MICBIAS"},
+};
+
+//软件复位并主机上电,整段绕过缓存一次下发,延时由regmap按表执行
+static const struct reg_sequence adau19xx_power_up_seq[] = {
+    { ADAU19XX_REG_POWER, ADAU19XX_POWER_RESET, ADAU19XX_SOFT_RESET_DELAY_US },
+    { ADAU19XX_REG_POWER, ADAU19XX_POWER_PWUP, ADAU19XX_PWUP_DELAY_US },
+};
+
+static ktime_t adau19xx_pwr_phase_end(struct adau1977 *adau19xx, enum adau19xx_pwr_phase phase, ktime_t start) {
+    ktime_t now = ktime_get();
+
+    adau19xx->pwr_phase_us[phase] = ktime_us_delta(now, start);
+    return now;
 }
 
 static int adau19xx_power_disable(struct adau1977 *adau19xx) {
@@ -221,101 +466,322 @@ static int adau19xx_power_disable(struct adau1977 *adau19xx) {
     regcache_cache_only(adau19xx->regmap, true);
 
     adau19xx->enabled = false;
+    adau19xx_res_set(adau19xx, ADAU19XX_RES_POWERED, 0);
 
     return 0;
 }
 
-static int adau19xx_power_enable(struct adau1977 *adau19xx) {
+static int __adau19xx_power_enable(struct adau1977 *adau19xx, ktime_t t) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("adau19xx:%s \n", __FUNCTION__);
-    pr_info("adau19xx->enabled init:%d \n", adau19xx->enabled);
-    pr_info("adau19xx->reset_gpio:0x%x \n", adau19xx->reset_gpio);
+    dev_info(adau19xx->dev, "adau19xx:%s \n", __FUNCTION__);
+    dev_info(adau19xx->dev, "adau19xx->enabled init:%d \n", adau19xx->enabled);
+    dev_info(adau19xx->dev, "adau19xx->reset_gpio:%p \n", adau19xx->reset_gpio);
 #endif
     unsigned int val;
     int ret = 0;
 
-    if (adau19xx->enabled)
-        return 0;
-
-    if (adau19xx->reset_gpio)
+    if (adau19xx->reset_gpio) {
         gpiod_set_value_cansleep(adau19xx->reset_gpio, 1);
+        usleep_range(ADAU19XX_RESET_GPIO_DELAY_US, ADAU19XX_RESET_GPIO_DELAY_US * 2);
+    }
+
+    //硬复位后芯片回到I2C模式,SPI需要重新切换
+    if (adau19xx->switch_mode)
+        adau19xx->switch_mode(adau19xx->dev);
+    t = adau19xx_pwr_phase_end(adau19xx, ADAU19XX_PWR_PHASE_GPIO, t);
 
     regcache_cache_only(adau19xx->regmap, false); //cache only mode, 在这种模式下，写操作将仅更新CACHE值，不会真正设置到硬件中
 
-    ret = adau19xx_reset(adau19xx);
+    ret = regmap_multi_reg_write_bypassed(adau19xx->regmap, adau19xx_power_up_seq,
+            ARRAY_SIZE(adau19xx_power_up_seq));
     if (ret) {
+#ifdef CONFIG_ADAU19XX_DEBUG
+        dev_err(adau19xx->dev, "soft reset/power up error! \n");
+#endif
         return ret;
     }
+    t = adau19xx_pwr_phase_end(adau19xx, ADAU19XX_PWR_PHASE_RESET, t);
 
-    ret = regmap_update_bits(adau19xx->regmap, ADAU19XX_REG_POWER, ADAU19XX_POWER_PWUP, ADAU19XX_POWER_PWUP);
+    ret = regcache_sync(adau19xx->regmap);
     if (ret) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-        pr_err("power up error! \n");
+        dev_err(adau19xx->dev, "regcache_sync error! \n");
 #endif
         return ret;
     }
-#ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("power up ok! \n");
-#endif
-    ret = regcache_sync(adau19xx->regmap);
+    t = adau19xx_pwr_phase_end(adau19xx, ADAU19XX_PWR_PHASE_SYNC, t);
+
+    //上电序列绕过了缓存,这里只更新缓存中的PWUP位,不产生总线访问
+    regcache_cache_only(adau19xx->regmap, true);
+    ret = regmap_update_bits(adau19xx->regmap, ADAU19XX_REG_POWER, ADAU19XX_POWER_PWUP, ADAU19XX_POWER_PWUP);
+    regcache_cache_only(adau19xx->regmap, false);
     if (ret) {
-#ifdef CONFIG_ADAU19XX_DEBUG
-        pr_err("regcache_sync error! \n");
-#endif
+        dev_err(adau19xx->dev, "update PWUP in cache failed: %d\n", ret);
         return ret;
     }
 
+    //PLL为默认值时regcache_sync不会写它,需要重写一次才能启动PLL
     ret = regmap_read(adau19xx->regmap, ADAU19XX_REG_PLL, &val);
     if (ret) {
-#ifdef CONFIG_ADAU19XX_DEBUG
-        pr_err("read PLL status error! \n");
-#endif
+        dev_err(adau19xx->dev, "read PLL from cache failed: %d\n", ret);
         return ret;
     }
-#ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("read PLL status ok!\n");
-#endif
     if (val == 0x41) {
-        regcache_cache_bypass(adau19xx->regmap, true); // 设置读写寄存器不通过cache模式而是bypass模式，读写立即生效，一般在audio等确保时序性驱动中用到 
-        ret = regmap_write(adau19xx->regmap, ADAU19XX_REG_PLL, 0x41);
-        regcache_cache_bypass(adau19xx->regmap, false);
+        struct reg_sequence pll_seq = { ADAU19XX_REG_PLL, val };
+
+        ret = regmap_multi_reg_write_bypassed(adau19xx->regmap, &pll_seq, 1);
         if (ret) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-            pr_err("write PLL status = 0x41 failed!\n");
+            dev_err(adau19xx->dev, "write PLL status = 0x41 failed!\n");
 #endif
             return ret;
         }
+    }
+    adau19xx_pwr_phase_end(adau19xx, ADAU19XX_PWR_PHASE_PLL, t);
+
 #ifdef CONFIG_ADAU19XX_DEBUG
-        pr_info("write PLL status = 0x41 ok!\n");
+    dev_info(adau19xx->dev, "power up: gpio %uus reset %uus sync %uus pll %uus\n",
+            adau19xx->pwr_phase_us[ADAU19XX_PWR_PHASE_GPIO],
+            adau19xx->pwr_phase_us[ADAU19XX_PWR_PHASE_RESET],
+            adau19xx->pwr_phase_us[ADAU19XX_PWR_PHASE_SYNC],
+            adau19xx->pwr_phase_us[ADAU19XX_PWR_PHASE_PLL]);
 #endif
-    }
 
     adau19xx->enabled = true;
+    adau19xx_res_set(adau19xx, ADAU19XX_RES_POWERED, 1);
+
+    //软件复位会丢失校准结果,上电时不做校准(最长100ms),只记下待补做,
+    //由复位后第一次打开音频流时执行
+    adau19xx->dc_cal_pending = adau19xx->dc_cal_done;
+
+    return 0;
+}
+
+static int adau19xx_power_enable(struct adau1977 *adau19xx) {
+    unsigned int prev;
+    ktime_t start;
+    int ret;
+
+    if (adau19xx->enabled)
+        return 0;
+
+    start = ktime_get();
+    prev = adau19xx_phase_enter(adau19xx, ADAU19XX_PROF_POWER_UP);
+    ret = __adau19xx_power_enable(adau19xx, start);
+    adau19xx_phase_exit(adau19xx, prev);
+    if (ret == 0)
+        adau19xx_prof_record(adau19xx, ADAU19XX_PROF_POWER_UP, start);
 
     return ret;
 }
 
-static bool adau19xx_check_sysclk(unsigned int mclk, unsigned int base_freq) {
-#ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("-----------------------------------\n");
-    pr_info("adau19xx:%s \n", __FUNCTION__);
-#endif
-    unsigned int mcs;
+//检查一项<reg val>,按当前型号的regmap可写/易失规则判断;不合法时返回原因
+static const char *adau19xx_reg_seq_invalid(struct adau1977 *adau19xx, u32 reg, u32 val) {
+    const struct regmap_config *config = adau19xx->variant->regmap_config;
+
+    if (reg >= ADAU19XX_NUM_REGS || !config->writeable_reg(adau19xx->dev, reg))
+        return "register not writeable on this chip";
+    if (config->volatile_reg(adau19xx->dev, reg))
+        return "volatile register";
+    if (val > 0xff)
+        return "value out of range";
+    //电源/复位寄存器不允许出现,其他寄存器中驱动独占的位必须为0,写入时保持不变
+    if (adau19xx_reg_owned_bits(reg) == 0xff)
+        return "register managed by the driver";
+    if (val & adau19xx_reg_owned_bits(reg))
+        return "bits managed by the driver";
+    return NULL;
+}
+
+//从设备树读取<reg val>成对的寄存器列表,如 adi,init-regs = <0x0a 0x90 0x0b 0x90>;
+int adau19xx_of_read_reg_seq(struct adau1977 *adau19xx, struct device_node *np, const char *propname,
+        struct reg_sequence **seq, unsigned int *num) {
+    struct device *dev = adau19xx->dev;
+    struct reg_sequence *regs;
+    const char *why;
+    u32 *cells;
+    int count, i, ret;
 
-    if (mclk % (base_freq * 128) != 0)
-        return false;
+    *seq = NULL;
+    *num = 0;
 
-    mcs = mclk / (128 * base_freq);
-    if (mcs < 1 || mcs > 6 || mcs == 5)
-        return false;
+    count = of_property_count_u32_elems(np, propname);
+    if (count <= 0)
+        return 0;
+    if (count % 2) {
+        dev_err(dev, "%s: expected <reg val> pairs\n", propname);
+        return -EINVAL;
+    }
 
+    cells = kcalloc(count, sizeof (*cells), GFP_KERNEL);
+    if (!cells)
+        return -ENOMEM;
+
+    ret = of_property_read_u32_array(np, propname, cells, count);
+    if (ret)
+        goto out;
+
+    regs = devm_kcalloc(dev, count / 2, sizeof (*regs), GFP_KERNEL);
+    if (!regs) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    for (i = 0; i < count / 2; i++) {
+        why = adau19xx_reg_seq_invalid(adau19xx, cells[2 * i], cells[2 * i + 1]);
+        if (why) {
+            dev_err(dev, "%s: entry %d <0x%02x 0x%02x>: %s\n", propname, i,
+                    cells[2 * i], cells[2 * i + 1], why);
+            ret = -EINVAL;
+            goto out;
+        }
+        regs[i].reg = cells[2 * i];
+        regs[i].def = cells[2 * i + 1];
+    }
+
+    *seq = regs;
+    *num = count / 2;
+out:
+    kfree(cells);
+    return ret;
+}
+EXPORT_SYMBOL_GPL(adau19xx_of_read_reg_seq);
+
+//一次总线传输从硬件连续读取count个寄存器,不经过缓存;
+//不切换cache_bypass,不影响其他路径并发的缓存读写.调用者持有adau19xx->lock以保证芯片已上电
+int adau19xx_hw_bulk_read(struct adau1977 *adau19xx, unsigned int reg, u8 *buf, size_t count) {
+    return adau19xx_bus_hw_read(adau19xx->bus, reg, buf, count);
+}
+EXPORT_SYMBOL_GPL(adau19xx_hw_bulk_read);
+
+//比较硬件与缓存中的关键寄存器,只比较软件可写且有意义的位
+static bool adau19xx_watchdog_sig_ok(struct adau1977 *adau19xx, const u8 *hw) {
+    static const struct {
+        unsigned int reg;
+        unsigned int mask;
+    } sig[] = {
+        { ADAU19XX_REG_POWER, ADAU19XX_POWER_PWUP },
+        { ADAU19XX_REG_PLL, ADAU19XX_PLL_CLK_S | ADAU19XX_PLL_MCS_MASK },
+        { ADAU19XX_REG_SAI_CTRL0, 0xff },
+    };
+    unsigned int val;
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(sig); i++) {
+        if (regmap_read(adau19xx->regmap, sig[i].reg, &val))
+            return false;
+        if ((val ^ hw[sig[i].reg - ADAU19XX_WDT_SIG_FIRST]) & sig[i].mask) {
+            dev_warn(adau19xx->dev, "watchdog: reg 0x%02x hw 0x%02x cache 0x%02x\n",
+                    sig[i].reg, hw[sig[i].reg - ADAU19XX_WDT_SIG_FIRST], val);
+            return false;
+        }
+    }
     return true;
 }
 
-static int adau_set_dai_sysclk(struct snd_soc_dai *dai, int clk_id, unsigned int freq, int dir) {
+//按缓存恢复硬件,音频流保持打开;手动恢复模式下顺带清除升压故障
+//芯片仍处于上电状态时只把缓存重新同步到硬件;PWUP已丢失(芯片复位或掉电)时才走完整上电流程
+static int adau19xx_recover(struct adau1977 *adau19xx, bool powered) {
+    unsigned int val;
+    int ret;
+
+    if (powered) {
+        //不先mark_dirty:regcache_sync_region此时不跳过默认值,被改写成其他值的默认值寄存器也会重写
+        ret = regcache_sync_region(adau19xx->regmap, 0, ADAU19XX_NUM_REGS - 1);
+    } else {
+        adau19xx->enabled = false;
+        regcache_mark_dirty(adau19xx->regmap);
+        ret = adau19xx_power_enable(adau19xx);
+    }
+    if (ret)
+        return ret;
+
+    if (!adau19xx->variant->has_micbias)
+        return 0;
+
+    regmap_read(adau19xx->regmap, ADAU19XX_REG_MICBIAS, &val);
+    if ((val & ADAU19XX_MICBIAS_BOOST_EN) && (val & ADAU19XX_MICBIAS_BOOST_RECOV)) {
+        struct reg_sequence boost_seq[] = {
+            { ADAU19XX_REG_MICBIAS, val & ~ADAU19XX_MICBIAS_BOOST_EN },
+            { ADAU19XX_REG_MICBIAS, val },
+        };
+
+        ret = regmap_multi_reg_write_bypassed(adau19xx->regmap, boost_seq, ARRAY_SIZE(boost_seq));
+    }
+
+    return ret;
+}
+
+//读取签名并与缓存比较,返回0=一致,1=不一致,<0=读取失败
+//分段读取,跳过ADAU1978/1979没有的0x02/0x03
+static int adau19xx_watchdog_check(struct adau1977 *adau19xx, u8 *hw) {
+    static const struct {
+        unsigned int reg;
+        unsigned int num;
+    } reads[] = {
+        { ADAU19XX_REG_POWER, 2 }, //POWER, PLL
+        { ADAU19XX_REG_SAI_CTRL0, 1 },
+    };
+    int i, ret;
+
+    for (i = 0; i < ARRAY_SIZE(reads); i++) {
+        ret = adau19xx_hw_bulk_read(adau19xx, reads[i].reg, hw + reads[i].reg - ADAU19XX_WDT_SIG_FIRST,
+                reads[i].num);
+        if (ret)
+            return ret;
+    }
+
+    return adau19xx_watchdog_sig_ok(adau19xx, hw) ? 0 : 1;
+}
+
+static void adau19xx_watchdog_work(struct work_struct *work) {
+    struct adau1977 *adau19xx = container_of(to_delayed_work(work), struct adau1977, watchdog_work);
+    u8 hw[ADAU19XX_WDT_SIG_NUM];
+    int ret;
+
+    mutex_lock(&adau19xx->lock);
+    if (adau19xx->enabled) {
+        adau19xx->wdt_checks++;
+        //一次读失败或不一致可能只是总线上的瞬时干扰,间隔一个重试退避后复查一次
+        ret = adau19xx_watchdog_check(adau19xx, hw);
+        if (ret) {
+            usleep_range(ADAU19XX_BUS_RETRY_MAX_US, ADAU19XX_BUS_RETRY_MAX_US * 2);
+            ret = adau19xx_watchdog_check(adau19xx, hw);
+        }
+
+        if (ret) {
+            ktime_t t = ktime_get();
+            unsigned int prev;
+            //读不出签名时按芯片已掉电处理
+            bool powered = ret > 0 && (hw[ADAU19XX_REG_POWER - ADAU19XX_WDT_SIG_FIRST] & ADAU19XX_POWER_PWUP);
+
+            //先把故障前的寄存器操作打印出来,恢复过程会覆盖部分记录
+            adau19xx_trace_dump(adau19xx->bus, adau19xx->dev, ADAU19XX_TRACE_DUMP_ON_FAULT);
+
+            prev = adau19xx_phase_enter(adau19xx, ADAU19XX_PROF_RECOVER);
+            ret = adau19xx_recover(adau19xx, powered);
+            adau19xx_phase_exit(adau19xx, prev);
+            adau19xx_prof_record(adau19xx, ADAU19XX_PROF_RECOVER, t);
+            adau19xx->wdt_recoveries++;
+            dev_warn(adau19xx->dev, "watchdog: %s #%u %s (%d)\n", powered ? "resync" : "power-up",
+                    adau19xx->wdt_recoveries, ret ? "failed" : "done", ret);
+        }
+    }
+    mutex_unlock(&adau19xx->lock);
+
+    schedule_delayed_work(&adau19xx->watchdog_work, msecs_to_jiffies(adau19xx->watchdog_ms));
+}
+
+static void adau19xx_watchdog_stop(void *data) {
+    struct adau1977 *adau19xx = data;
+
+    cancel_delayed_work_sync(&adau19xx->watchdog_work);
+}
+
+static int __adau_set_dai_sysclk(struct snd_soc_dai *dai, int clk_id, unsigned int freq, int dir) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("-----------------------------------\n");
-    pr_info("adau19xx:%s \n", __FUNCTION__);
+    dev_info(dai->dev, "-----------------------------------\n");
+    dev_info(dai->dev, "adau19xx:%s \n", __FUNCTION__);
 #endif
     int ret = 0;
     struct snd_soc_codec *codec = dai->codec;
@@ -325,9 +791,9 @@ static int adau_set_dai_sysclk(struct snd_soc_dai *dai, int clk_id, unsigned int
     int source = adau19xx->sysclk_src;
     freq = 12288000;
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("dir=%d \n", dir);
-    pr_info("clk_id=%d \n", clk_id);
-    pr_info("freq=%d \n", freq);
+    dev_info(dai->dev, "dir=%d \n", dir);
+    dev_info(dai->dev, "clk_id=%d \n", clk_id);
+    dev_info(dai->dev, "freq=%d \n", freq);
 #endif
 
     if (dir != SND_SOC_CLOCK_IN)
@@ -340,20 +806,24 @@ static int adau_set_dai_sysclk(struct snd_soc_dai *dai, int clk_id, unsigned int
         case ADAU19XX_SYSCLK_SRC_MCLK:
             clk_src = 0;
 #ifdef CONFIG_ADAU19XX_DEBUG
-            pr_info("ADAU19XX_SYSCLK_SRC_MCLK\n");
+            dev_info(dai->dev, "ADAU19XX_SYSCLK_SRC_MCLK\n");
 #endif
             break;
         case ADAU19XX_SYSCLK_SRC_LRCLK:
             clk_src = ADAU19XX_PLL_CLK_S;
 #ifdef CONFIG_ADAU19XX_DEBUG
-            pr_info("ADAU19XX_SYSCLK_SRC_LRCLK\n");
+            dev_info(dai->dev, "ADAU19XX_SYSCLK_SRC_LRCLK\n");
 #endif
             break;
+        case ADAU19XX_SYSCLK_SRC_AUTO:
+            //PLL时钟源在hw_params中按采样率选择
+            clk_src = 0;
+            break;
         default:
             return -EINVAL;
     }
 
-    if (freq != 0 && source == ADAU19XX_SYSCLK_SRC_MCLK) {
+    if (freq != 0 && source != ADAU19XX_SYSCLK_SRC_LRCLK) {
         if (freq < 4000000 || freq > 36864000)
             return -EINVAL;
 
@@ -366,39 +836,56 @@ static int adau_set_dai_sysclk(struct snd_soc_dai *dai, int clk_id, unsigned int
 
         if (mask == 0)
             return -EINVAL;
+        adau19xx->mclk_mask = mask;
+        //自动模式:MCLK可产生的采样率与LRCLK模式支持的采样率取并集
+        if (source == ADAU19XX_SYSCLK_SRC_AUTO)
+            mask |= ADAU19XX_RATE_CONSTRAINT_MASK_LRCLK;
     } else if (source == ADAU19XX_SYSCLK_SRC_LRCLK) {
         mask = ADAU19XX_RATE_CONSTRAINT_MASK_LRCLK;
     }
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("mask = 0x%2x\n", mask);
+    dev_info(dai->dev, "mask = 0x%2x\n", mask);
 #endif
-    ret = regmap_update_bits(adau19xx->regmap, ADAU19XX_REG_PLL,
-            ADAU19XX_PLL_CLK_S, clk_src);
-    if (ret) {
+    if (source != ADAU19XX_SYSCLK_SRC_AUTO) {
+        ret = regmap_update_bits(adau19xx->regmap, ADAU19XX_REG_PLL,
+                ADAU19XX_PLL_CLK_S, clk_src);
+        if (ret) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-        pr_info("ADAU19XX_REG_PLL set failed! \n");
+            dev_info(dai->dev, "ADAU19XX_REG_PLL set failed! \n");
 #endif
-        return ret;
+            return ret;
+        }
     }
 
     adau19xx->constraints.mask = mask;
     //adau19xx->sysclk_src = source;
     adau19xx->sysclk = freq;
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("adau19xx->constraints.mask=%d \n", adau19xx->constraints.mask);
-    pr_info("adau19xx->sysclk_src=%d \n", adau19xx->sysclk_src);
-    pr_info("adau19xx->sysclk=%d \n", adau19xx->sysclk);
+    dev_info(dai->dev, "adau19xx->constraints.mask=%d \n", adau19xx->constraints.mask);
+    dev_info(dai->dev, "adau19xx->sysclk_src=%d \n", adau19xx->sysclk_src);
+    dev_info(dai->dev, "adau19xx->sysclk=%d \n", adau19xx->sysclk);
 #endif
     return 0;
 }
 
+//同步启动组,定义见后
+static void adau19xx_group_set_active(struct adau1977 *adau19xx, bool active);
+
 static int adau19xx_startup(struct snd_pcm_substream *substream,
         struct snd_soc_dai *dai) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("-----------------------------------\n");
-    pr_info("adau19xx:%s \n", __FUNCTION__);
+    dev_info(dai->dev, "-----------------------------------\n");
+    dev_info(dai->dev, "adau19xx:%s \n", __FUNCTION__);
 #endif
     struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(dai->codec);
+    ktime_t t = ktime_get();
+
+    adau19xx->stream_start = t; //从startup到解除静音计为一次完整的打流耗时
+
+    //自动模式下作为时钟主机时只能用MCLK
+    if (adau19xx->sysclk_src == ADAU19XX_SYSCLK_SRC_AUTO)
+        adau19xx->constraints.mask = adau19xx->master ? adau19xx->mclk_mask :
+                adau19xx->mclk_mask | ADAU19XX_RATE_CONSTRAINT_MASK_LRCLK;
 
     snd_pcm_hw_constraint_list(substream->runtime, 0,
             SNDRV_PCM_HW_PARAM_RATE, &adau19xx->constraints);
@@ -407,83 +894,59 @@ static int adau19xx_startup(struct snd_pcm_substream *substream,
         snd_pcm_hw_constraint_minmax(substream->runtime,
             SNDRV_PCM_HW_PARAM_RATE, 8000, adau19xx->max_master_fs);
 
+    if (adau19xx->group)
+        adau19xx_group_set_active(adau19xx, true);
+
+    adau19xx_prof_record(adau19xx, ADAU19XX_PROF_STARTUP, t);
     return 0;
 }
 
-static int adau19xx_lookup_fs(unsigned int rate) {
-    int ret = -EINVAL;
-
-    if (rate >= 8000 && rate <= 12000)
-        ret = ADAU19XX_SAI_CTRL0_FS_8000_12000;
-    else if (rate >= 16000 && rate <= 24000)
-        ret = ADAU19XX_SAI_CTRL0_FS_16000_24000;
-    else if (rate >= 32000 && rate <= 48000)
-        ret = ADAU19XX_SAI_CTRL0_FS_32000_48000;
-    else if (rate >= 64000 && rate <= 96000)
-        ret = ADAU19XX_SAI_CTRL0_FS_64000_96000;
-    else if (rate >= 128000 && rate <= 192000)
-        ret = ADAU19XX_SAI_CTRL0_FS_128000_192000;
-    else
-        ret = -EINVAL;
+static void adau19xx_shutdown(struct snd_pcm_substream *substream,
+        struct snd_soc_dai *dai) {
+    struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(dai->codec);
 
-#ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("+adau19xx:%s \n", __FUNCTION__);
-    pr_info("fs rate reg:0x%02x\n", ret);
-#endif
-    return ret;
+    //关闭音频流的成员不再参与同步,其他成员不必等它
+    if (adau19xx->group)
+        adau19xx_group_set_active(adau19xx, false);
 }
 
-static int adau19xx_lookup_mcs(struct adau1977 *adau19xx, unsigned int rate, unsigned int fs) {
-    unsigned int mcs;
-#ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("+adau19xx:%s \n", __FUNCTION__);
-    pr_info("rate=%d fs=%d\n", rate, fs);
-#endif
-    /*
-     * rate = sysclk / (512 * mcs_lut[mcs]) * 2**fs
-     * => mcs_lut[mcs] = sysclk / (512 * rate) * 2**fs
-     * => mcs_lut[mcs] = sysclk / ((512 / 2**fs) * rate)
-     */
-    rate *= 512 >> fs;
-
-#ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("rate final=%d \n", rate);
-    pr_info("adau19xx->sysclk=%d \n", adau19xx->sysclk);
-#endif
+//自动模式:作为从机且采样率不低于32K时用LRCLK,PLL直接锁定主机的帧时钟,
+//不存在MCLK与LRCLK不同源造成的漂移,也省去MCLK模式BIAS_ON中60ms的等待;
+//主机模式或低采样率时用MCLK
+static enum adau19xx_sysclk_src adau19xx_select_clk_src(struct adau1977 *adau19xx, unsigned int rate) {
+    if (adau19xx->sysclk_src != ADAU19XX_SYSCLK_SRC_AUTO)
+        return adau19xx->sysclk_src;
 
-    if (adau19xx->sysclk % rate != 0) {
-#ifdef CONFIG_ADAU19XX_DEBUG
-        pr_err("lookup mcs failed\n");
-#endif
-        return -EINVAL;
-    }
+    if (!adau19xx->master && rate >= 32000)
+        return ADAU19XX_SYSCLK_SRC_LRCLK;
 
-    mcs = adau19xx->sysclk / rate;
+    return ADAU19XX_SYSCLK_SRC_MCLK;
+}
 
-    /* The factors configured by MCS are 1, 2, 3, 4, 6 */
-    if (mcs < 1 || mcs > 6 || mcs == 5) {
+static int adau19xx_lookup_mcs(struct adau1977 *adau19xx, unsigned int rate, unsigned int fs) {
+    int mcs;
 #ifdef CONFIG_ADAU19XX_DEBUG
-        pr_info("lookup mcs failed\n");
+    dev_info(adau19xx->dev, "+adau19xx:%s \n", __FUNCTION__);
+    dev_info(adau19xx->dev, "rate=%d fs=%d\n", rate, fs);
+    dev_info(adau19xx->dev, "adau19xx->sysclk=%d \n", adau19xx->sysclk);
 #endif
-        return -EINVAL;
-    }
-
-    mcs = mcs - 1;
-    if (mcs == 5)
-        mcs = 4;
 
+    mcs = adau19xx_calc_mcs(adau19xx->sysclk, rate, fs);
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("mcs=%d\n", mcs);
+    if (mcs < 0)
+        dev_err(adau19xx->dev, "lookup mcs failed\n");
+    else
+        dev_info(adau19xx->dev, "mcs=%d\n", mcs);
 #endif
 
     return mcs;
 }
 
-static int adau19xx_hw_params(struct snd_pcm_substream *substream,
+static int __adau19xx_hw_params(struct snd_pcm_substream *substream,
         struct snd_pcm_hw_params *params, struct snd_soc_dai *dai) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("-----------------------------------\n");
-    pr_info("adau19xx:%s \n", __FUNCTION__);
+    dev_info(dai->dev, "-----------------------------------\n");
+    dev_info(dai->dev, "adau19xx:%s \n", __FUNCTION__);
 #endif
     struct snd_soc_codec *codec = dai->codec;
     struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(codec);
@@ -491,18 +954,20 @@ static int adau19xx_hw_params(struct snd_pcm_substream *substream,
     unsigned int slot_width;
     unsigned int ctrl0, ctrl0_mask;
     unsigned int ctrl1;
+    enum adau19xx_sysclk_src src;
     int mcs, fs;
     int ret;
 
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("adau19xx->sysclk_src =%d \n", adau19xx->sysclk_src);
+    dev_info(dai->dev, "adau19xx->sysclk_src =%d \n", adau19xx->sysclk_src);
 #endif
 
     fs = adau19xx_lookup_fs(rate);
     if (fs < 0)
         return fs;
 
-    if (adau19xx->sysclk_src == ADAU19XX_SYSCLK_SRC_MCLK) {
+    src = adau19xx_select_clk_src(adau19xx, rate);
+    if (src == ADAU19XX_SYSCLK_SRC_MCLK) {
         mcs = adau19xx_lookup_mcs(adau19xx, rate, fs);
         if (mcs < 0)
             return mcs;
@@ -510,7 +975,10 @@ static int adau19xx_hw_params(struct snd_pcm_substream *substream,
         mcs = 0;
     }
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("final mcs =%d \n", mcs);
+    dev_info(dai->dev, "clk src =%d \n", src);
+#endif
+#ifdef CONFIG_ADAU19XX_DEBUG
+    dev_info(dai->dev, "final fs =%d mcs =%d \n", fs, mcs);
 #endif
     ctrl0_mask = ADAU19XX_SAI_CTRL0_FS_MASK;
     ctrl0 = fs;
@@ -530,8 +998,8 @@ static int adau19xx_hw_params(struct snd_pcm_substream *substream,
     }
 
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("adau19xx->right_j =%d \n", adau19xx->right_j);
-    pr_info("params_width(params) =%d \n", params_width(params));
+    dev_info(dai->dev, "adau19xx->right_j =%d \n", adau19xx->right_j);
+    dev_info(dai->dev, "params_width(params) =%d \n", params_width(params));
 #endif
 
     if (adau19xx->master) {
@@ -568,40 +1036,315 @@ static int adau19xx_hw_params(struct snd_pcm_substream *substream,
     }
 
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("adau19xx->master =%d \n", adau19xx->master);
-    pr_info("adau19xx->slot_width =%d \n", adau19xx->slot_width);
-    pr_info("slot_width =%d \n", slot_width);
+    dev_info(dai->dev, "adau19xx->master =%d \n", adau19xx->master);
+    dev_info(dai->dev, "adau19xx->slot_width =%d \n", adau19xx->slot_width);
+    dev_info(dai->dev, "slot_width =%d \n", slot_width);
 #endif
 
     ret = regmap_update_bits(adau19xx->regmap, ADAU19XX_REG_SAI_CTRL0, ctrl0_mask, ctrl0);
     if (ret < 0)
         return ret;
 
-    ret = regmap_update_bits(adau19xx->regmap, ADAU19XX_REG_PLL, ADAU19XX_PLL_MCS_MASK, mcs);
+    if (src == ADAU19XX_SYSCLK_SRC_LRCLK)
+        mcs |= ADAU19XX_PLL_CLK_S;
+    ret = regmap_update_bits(adau19xx->regmap, ADAU19XX_REG_PLL,
+            ADAU19XX_PLL_MCS_MASK | ADAU19XX_PLL_CLK_S, mcs);
+    if (ret < 0)
+        return ret;
+    adau19xx->clk_src = src;
+
+    //主机模式:每帧左右两个slot
+    if (adau19xx->master)
+        adau19xx_clk_set_rates(adau19xx, rate * slot_width * 2, rate);
+
+    return 0;
+}
+
+static int adau19xx_hw_free(struct snd_pcm_substream *substream,
+        struct snd_soc_dai *dai) {
+    struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(dai->codec);
+
+    adau19xx_clk_set_rates(adau19xx, 0, 0);
+    return 0;
+}
+
+//同步启动组:同一组内打开了音频流的芯片全部完成配置并请求解除静音后,
+//再连续重启各芯片的ADC并解除静音,使各芯片的抽取滤波器从同一帧附近开始工作、输出有效数据
+//没有打开音频流的成员不参与等待;已就绪的成员最多等待ADAU19XX_GROUP_SYNC_TIMEOUT_MS
+static LIST_HEAD(adau19xx_groups);
+static DEFINE_MUTEX(adau19xx_group_lock);
+
+static bool adau19xx_group_pending(struct adau1977 *member) {
+    return member->group_armed && !member->group_running;
+}
+
+//批量操作期间锁住待解除静音成员的DAPM和adau19xx->lock:
+//DAPM不会同时改写BLOCK_POWER_SAI的使能位,看门狗恢复和上电流程也不会在中途同步缓存;
+//加锁顺序与DAPM回调中上电一致(dapm_mutex -> adau19xx->lock),多个声卡只锁一次
+static void adau19xx_group_lock_members(struct adau19xx_group *group, bool lock) {
+    struct adau1977 *member, *prev;
+    struct snd_soc_card *card;
+    unsigned int n = 0;
+
+    list_for_each_entry(member, &group->members, group_node) {
+        if (!adau19xx_group_pending(member))
+            continue;
+        card = member->codec->component.card;
+        list_for_each_entry(prev, &group->members, group_node) {
+            if (prev == member || (adau19xx_group_pending(prev) && prev->codec->component.card == card))
+                break;
+        }
+        if (prev == member) {
+            if (lock)
+                mutex_lock_nested(&card->dapm_mutex, n);
+            else
+                mutex_unlock(&card->dapm_mutex);
+        }
+        if (lock)
+            mutex_lock_nested(&member->lock, n);
+        else
+            mutex_unlock(&member->lock);
+        n++;
+    }
+}
+
+//调用者持有adau19xx_group_lock;对已就绪但尚未解除静音的成员批量操作:
+//先关闭全部这些芯片的ADC,再逐个按缓存恢复ADC使能并解除静音,两步都是连续的总线写入
+//持锁期间缓存中的使能位不会变化,绕过缓存的两次写入结束后硬件与缓存重新一致
+static int adau19xx_group_release(struct adau19xx_group *group) {
+    struct adau1977 *member;
+    struct reg_sequence seq;
+    unsigned int val;
+    int ret = 0, err;
+
+    cancel_delayed_work(&group->release_work);
+    adau19xx_group_lock_members(group, true);
+
+    list_for_each_entry(member, &group->members, group_node) {
+        if (!adau19xx_group_pending(member))
+            continue;
+        //ADC使能位由DAPM维护在缓存中,这里绕过缓存临时关闭,缓存不变
+        err = regmap_read(member->regmap, ADAU19XX_REG_BLOCK_POWER_SAI, &val);
+        if (!err) {
+            seq.reg = ADAU19XX_REG_BLOCK_POWER_SAI;
+            seq.def = val & ~ADAU19XX_BLOCK_POWER_SAI_ADC_EN_MASK;
+            seq.delay_us = 0;
+            err = regmap_multi_reg_write_bypassed(member->regmap, &seq, 1);
+        }
+        if (err && !ret)
+            ret = err;
+    }
+
+    list_for_each_entry(member, &group->members, group_node) {
+        if (!adau19xx_group_pending(member))
+            continue;
+        err = regmap_read(member->regmap, ADAU19XX_REG_BLOCK_POWER_SAI, &val);
+        if (!err) {
+            seq.reg = ADAU19XX_REG_BLOCK_POWER_SAI;
+            seq.def = val;
+            seq.delay_us = 0;
+            err = regmap_multi_reg_write_bypassed(member->regmap, &seq, 1);
+        }
+        if (!err)
+            err = regmap_update_bits(member->regmap, ADAU19XX_REG_MISC_CONTROL,
+                    ADAU19XX_MISC_CONTROL_MMUTE, 0);
+        if (err && !ret)
+            ret = err;
+    }
+
+    //先解锁再标记,解锁时需要按同样的成员集合遍历
+    adau19xx_group_lock_members(group, false);
+    list_for_each_entry(member, &group->members, group_node) {
+        if (adau19xx_group_pending(member))
+            member->group_running = true;
+    }
+
+    return ret;
+}
+
+//打开音频流的成员都已就绪时解除静音,否则开始计时
+static int adau19xx_group_update(struct adau19xx_group *group) {
+    if (!group->num_armed) {
+        cancel_delayed_work(&group->release_work);
+        return 0;
+    }
+
+    if (group->num_armed >= group->num_active)
+        return adau19xx_group_release(group);
+
+    if (!delayed_work_pending(&group->release_work))
+        schedule_delayed_work(&group->release_work, msecs_to_jiffies(ADAU19XX_GROUP_SYNC_TIMEOUT_MS));
+    return 0;
+}
+
+static void adau19xx_group_release_work(struct work_struct *work) {
+    struct adau19xx_group *group = container_of(to_delayed_work(work), struct adau19xx_group, release_work);
+    struct adau1977 *member;
+    int ret;
+
+    mutex_lock(&adau19xx_group_lock);
+    if (!group->num_armed) {
+        mutex_unlock(&adau19xx_group_lock);
+        return;
+    }
+    list_for_each_entry(member, &group->members, group_node) {
+        if (member->group_active && !member->group_armed)
+            dev_warn(member->dev, "sync group %u: not ready after %ums, starting without it\n",
+                    group->id, ADAU19XX_GROUP_SYNC_TIMEOUT_MS);
+    }
+    ret = adau19xx_group_release(group);
+    if (ret)
+        pr_warn("adau19xx: sync group %u: unmute failed: %d\n", group->id, ret);
+    mutex_unlock(&adau19xx_group_lock);
+}
+
+static int adau19xx_group_join(struct adau1977 *adau19xx, u32 id) {
+    struct adau19xx_group *group;
+
+    mutex_lock(&adau19xx_group_lock);
+    list_for_each_entry(group, &adau19xx_groups, list) {
+        if (group->id == id)
+            goto found;
+    }
+
+    group = kzalloc(sizeof (*group), GFP_KERNEL);
+    if (!group) {
+        mutex_unlock(&adau19xx_group_lock);
+        return -ENOMEM;
+    }
+    group->id = id;
+    INIT_LIST_HEAD(&group->members);
+    INIT_DELAYED_WORK(&group->release_work, adau19xx_group_release_work);
+    list_add_tail(&group->list, &adau19xx_groups);
+
+found:
+    list_add_tail(&adau19xx->group_node, &group->members);
+    group->num_members++;
+    adau19xx->group = group;
+    mutex_unlock(&adau19xx_group_lock);
+
+    return 0;
+}
+
+//成员不再等待:关闭音频流或移除设备,剩下的成员可能因此全部就绪
+static void adau19xx_group_deactivate(struct adau1977 *adau19xx) {
+    struct adau19xx_group *group = adau19xx->group;
+
+    if (adau19xx->group_armed) {
+        adau19xx->group_armed = false;
+        group->num_armed--;
+    }
+    if (adau19xx->group_active) {
+        adau19xx->group_active = false;
+        group->num_active--;
+    }
+    adau19xx->group_running = false;
+}
+
+static void adau19xx_group_leave(void *data) {
+    struct adau1977 *adau19xx = data;
+    struct adau19xx_group *group = adau19xx->group;
+    bool last;
+
+    mutex_lock(&adau19xx_group_lock);
+    adau19xx_group_deactivate(adau19xx);
+    list_del(&adau19xx->group_node);
+    last = --group->num_members == 0;
+    if (last)
+        list_del(&group->list);
+    else
+        adau19xx_group_update(group);
+    adau19xx->group = NULL;
+    mutex_unlock(&adau19xx_group_lock);
+
+    //超时任务会获取adau19xx_group_lock,需在锁外等待其结束
+    if (last) {
+        cancel_delayed_work_sync(&group->release_work);
+        kfree(group);
+    }
+}
+
+static void adau19xx_group_set_active(struct adau1977 *adau19xx, bool active) {
+    struct adau19xx_group *group = adau19xx->group;
+    int ret;
+
+    mutex_lock(&adau19xx_group_lock);
+    if (active && !adau19xx->group_active) {
+        adau19xx->group_active = true;
+        group->num_active++;
+    } else if (!active) {
+        adau19xx_group_deactivate(adau19xx);
+        ret = adau19xx_group_update(group);
+        if (ret)
+            dev_warn(adau19xx->dev, "sync group %u: unmute failed: %d\n", group->id, ret);
+    }
+    mutex_unlock(&adau19xx_group_lock);
+}
+
+static int adau19xx_group_mute(struct adau1977 *adau19xx, int mute) {
+    struct adau19xx_group *group = adau19xx->group;
+    int ret = 0;
+
+    mutex_lock(&adau19xx_group_lock);
+    if (mute) {
+        if (adau19xx->group_armed) {
+            adau19xx->group_armed = false;
+            group->num_armed--;
+        }
+        adau19xx->group_running = false;
+        ret = regmap_update_bits(adau19xx->regmap, ADAU19XX_REG_MISC_CONTROL,
+                ADAU19XX_MISC_CONTROL_MMUTE, ADAU19XX_MISC_CONTROL_MMUTE);
+    } else {
+        if (!adau19xx->group_armed) {
+            adau19xx->group_armed = true;
+            group->num_armed++;
+        }
+        //最后一个就绪的芯片负责一次性解除全组静音
+        ret = adau19xx_group_update(group);
+    }
+    mutex_unlock(&adau19xx_group_lock);
+
     return ret;
 }
 
 static int adau19xx_mute(struct snd_soc_dai *dai, int mute, int stream) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("-----------------------------------\n");
-    pr_info("adau19xx:%s \n", __FUNCTION__);
+    dev_info(dai->dev, "-----------------------------------\n");
+    dev_info(dai->dev, "adau19xx:%s \n", __FUNCTION__);
 #endif
     struct snd_soc_codec *codec = dai->codec;
     struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(dai->codec);
-    unsigned int val;
+    ktime_t t = ktime_get();
+    unsigned int val, prev;
+    int ret;
 
     if (mute) {
         val = ADAU19XX_MISC_CONTROL_MMUTE;
     } else {
         val = 0; //关闭静音
     }
-    return regmap_update_bits(adau19xx->regmap, ADAU19XX_REG_MISC_CONTROL, ADAU19XX_MISC_CONTROL_MMUTE, val);
+    prev = adau19xx_phase_enter(adau19xx, ADAU19XX_PROF_UNMUTE);
+    if (adau19xx->group)
+        ret = adau19xx_group_mute(adau19xx, mute);
+    else
+        ret = regmap_update_bits(adau19xx->regmap, ADAU19XX_REG_MISC_CONTROL, ADAU19XX_MISC_CONTROL_MMUTE, val);
+    adau19xx_phase_exit(adau19xx, prev);
+
+    if (!mute) {
+        adau19xx_prof_record(adau19xx, ADAU19XX_PROF_UNMUTE, t);
+        if (adau19xx->stream_start) {
+            adau19xx_prof_record(adau19xx, ADAU19XX_PROF_STREAM_OPEN, adau19xx->stream_start);
+            adau19xx->stream_start = 0;
+        }
+    }
+
+    return ret;
 }
 
-static int adau19xx_set_fmt(struct snd_soc_dai *dai, unsigned int fmt) {
+static int __adau19xx_set_fmt(struct snd_soc_dai *dai, unsigned int fmt) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("-----------------------------------\n");
-    pr_info("adau19xx:%s \n", __FUNCTION__);
+    dev_info(dai->dev, "-----------------------------------\n");
+    dev_info(dai->dev, "adau19xx:%s \n", __FUNCTION__);
 #endif
     int ret;
     struct snd_soc_codec *codec = dai->codec;
@@ -614,6 +1357,11 @@ static int adau19xx_set_fmt(struct snd_soc_dai *dai, unsigned int fmt) {
             adau19xx->master = false;
             break;
         case SND_SOC_DAIFMT_CBM_CFM:
+            //主机模式下LRCLK为输出,只能由MCLK经PLL产生BCLK/LRCLK
+            if (adau19xx->sysclk_src == ADAU19XX_SYSCLK_SRC_LRCLK) {
+                dev_err(dai->dev, "codec master mode requires sysclk-src = <0> or <2>\n");
+                return -EINVAL;
+            }
             ctrl1 |= ADAU19XX_SAI_CTRL1_MASTER;
             adau19xx->master = true;
             break;
@@ -621,8 +1369,8 @@ static int adau19xx_set_fmt(struct snd_soc_dai *dai, unsigned int fmt) {
             return -EINVAL;
     }
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("fmt & SND_SOC_DAIFMT_MASTER_MASK=%d \n", fmt & SND_SOC_DAIFMT_MASTER_MASK);
-    pr_info("adau19xx->master=%d \n", adau19xx->master);
+    dev_info(dai->dev, "fmt & SND_SOC_DAIFMT_MASTER_MASK=%d \n", fmt & SND_SOC_DAIFMT_MASTER_MASK);
+    dev_info(dai->dev, "adau19xx->master=%d \n", adau19xx->master);
 #endif
     switch (fmt & SND_SOC_DAIFMT_INV_MASK) {
         case SND_SOC_DAIFMT_NB_NF:
@@ -643,7 +1391,7 @@ static int adau19xx_set_fmt(struct snd_soc_dai *dai, unsigned int fmt) {
             return -EINVAL;
     }
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("fmt & SND_SOC_DAIFMT_INV_MASK=%d \n", fmt & SND_SOC_DAIFMT_INV_MASK);
+    dev_info(dai->dev, "fmt & SND_SOC_DAIFMT_INV_MASK=%d \n", fmt & SND_SOC_DAIFMT_INV_MASK);
 #endif
     adau19xx->right_j = false;
     switch (fmt & SND_SOC_DAIFMT_FORMAT_MASK) {
@@ -676,17 +1424,17 @@ static int adau19xx_set_fmt(struct snd_soc_dai *dai, unsigned int fmt) {
     if (invert_lrclk)
         block_power |= ADAU19XX_BLOCK_POWER_SAI_LR_POL;
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("fmt & SND_SOC_DAIFMT_FORMAT_MASK=%d \n", fmt & SND_SOC_DAIFMT_FORMAT_MASK);
-    pr_info("block_power=%d invert_lrclk=%d\n", block_power, invert_lrclk);
-    pr_info("ctrl0=%d ctrl1=%d\n", ctrl0, ctrl1);
-    pr_info("adau19xx->right_j=%d\n", adau19xx->right_j);
+    dev_info(dai->dev, "fmt & SND_SOC_DAIFMT_FORMAT_MASK=%d \n", fmt & SND_SOC_DAIFMT_FORMAT_MASK);
+    dev_info(dai->dev, "block_power=%d invert_lrclk=%d\n", block_power, invert_lrclk);
+    dev_info(dai->dev, "ctrl0=%d ctrl1=%d\n", ctrl0, ctrl1);
+    dev_info(dai->dev, "adau19xx->right_j=%d\n", adau19xx->right_j);
 #endif
 
     ret = regmap_update_bits(adau19xx->regmap, ADAU19XX_REG_BLOCK_POWER_SAI, ADAU19XX_BLOCK_POWER_SAI_LR_POL |
             ADAU19XX_BLOCK_POWER_SAI_BCLK_EDGE, block_power);
     if (ret) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-        pr_err("write LR_POL|BCLK_EDGE failed\n");
+        dev_err(dai->dev, "write LR_POL|BCLK_EDGE failed\n");
 #endif
         return ret;
     }
@@ -695,7 +1443,7 @@ static int adau19xx_set_fmt(struct snd_soc_dai *dai, unsigned int fmt) {
             ADAU19XX_SAI_CTRL0_FMT_MASK, ctrl0);
     if (ret) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-        pr_err("write ADAU19XX_SAI_CTRL0_FMT_MASK failed\n");
+        dev_err(dai->dev, "write ADAU19XX_SAI_CTRL0_FMT_MASK failed\n");
 #endif
         return ret;
     }
@@ -704,7 +1452,7 @@ static int adau19xx_set_fmt(struct snd_soc_dai *dai, unsigned int fmt) {
             ADAU19XX_SAI_CTRL1_MASTER | ADAU19XX_SAI_CTRL1_LRCLK_PULSE, ctrl1);
     if (ret) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-        pr_err("ADAU19XX_REG_SAI_CTRL1 set fail!\n");
+        dev_err(dai->dev, "ADAU19XX_REG_SAI_CTRL1 set fail!\n");
 #endif
         return ret;
     }
@@ -712,13 +1460,56 @@ static int adau19xx_set_fmt(struct snd_soc_dai *dai, unsigned int fmt) {
     return 0;
 }
 
+//以下包装函数只负责统计各阶段耗时
+static int adau_set_dai_sysclk(struct snd_soc_dai *dai, int clk_id, unsigned int freq, int dir) {
+    struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(dai->codec);
+    ktime_t t = ktime_get();
+    unsigned int prev;
+    int ret;
+
+    prev = adau19xx_phase_enter(adau19xx, ADAU19XX_PROF_SYSCLK);
+    ret = __adau_set_dai_sysclk(dai, clk_id, freq, dir);
+    adau19xx_phase_exit(adau19xx, prev);
+    adau19xx_prof_record(adau19xx, ADAU19XX_PROF_SYSCLK, t);
+    return ret;
+}
+
+static int adau19xx_hw_params(struct snd_pcm_substream *substream,
+        struct snd_pcm_hw_params *params, struct snd_soc_dai *dai) {
+    struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(dai->codec);
+    ktime_t t = ktime_get();
+    unsigned int prev;
+    int ret;
+
+    prev = adau19xx_phase_enter(adau19xx, ADAU19XX_PROF_HW_PARAMS);
+    ret = __adau19xx_hw_params(substream, params, dai);
+    adau19xx_phase_exit(adau19xx, prev);
+    adau19xx_prof_record(adau19xx, ADAU19XX_PROF_HW_PARAMS, t);
+    return ret;
+}
+
+static int adau19xx_set_fmt(struct snd_soc_dai *dai, unsigned int fmt) {
+    struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(dai->codec);
+    ktime_t t = ktime_get();
+    unsigned int prev;
+    int ret;
+
+    prev = adau19xx_phase_enter(adau19xx, ADAU19XX_PROF_SET_FMT);
+    ret = __adau19xx_set_fmt(dai, fmt);
+    adau19xx_phase_exit(adau19xx, prev);
+    adau19xx_prof_record(adau19xx, ADAU19XX_PROF_SET_FMT, t);
+    return ret;
+}
+
 static const struct snd_soc_dai_ops adau19xx_dai_ops = {
     //DAI clocking configuration
     .set_sysclk = adau_set_dai_sysclk,
 
     .startup = adau19xx_startup,
+    .shutdown = adau19xx_shutdown,
     //ALSA PCM audio operations
     .hw_params = adau19xx_hw_params,
+    .hw_free = adau19xx_hw_free,
     .mute_stream = adau19xx_mute,
     //DAI format configuration
     .set_fmt = adau19xx_set_fmt,
@@ -740,57 +1531,83 @@ static struct snd_soc_dai_driver adau19xx_dai = {
 
 static int adau19xx_add_widgets(struct snd_soc_codec *codec) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("-----------------------------------\n");
-    pr_info("adau19xx:%s \n", __FUNCTION__);
+    dev_info(codec->dev, "-----------------------------------\n");
+    dev_info(codec->dev, "adau19xx:%s \n", __FUNCTION__);
 #endif
     struct snd_soc_dapm_context *dapm = snd_soc_codec_get_dapm(codec);
+    struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(codec);
+    const struct adau19xx_variant *variant = adau19xx->variant;
+    int ret;
+
     snd_soc_add_codec_controls(codec, adau19xx_snd_controls, ARRAY_SIZE(adau19xx_snd_controls));
     snd_soc_dapm_new_controls(dapm, adau19xx_dapm_widgets, ARRAY_SIZE(adau19xx_dapm_widgets));
     snd_soc_dapm_add_routes(dapm, adau19xx_dapm_routes, ARRAY_SIZE(adau19xx_dapm_routes));
-    return 0;
+
+    //型号相关部分
+    snd_soc_add_codec_controls(codec, variant->controls, variant->num_controls);
+    snd_soc_dapm_new_controls(dapm, variant->widgets, variant->num_widgets);
+    snd_soc_dapm_add_routes(dapm, variant->routes, variant->num_routes);
+    if (variant->has_micbias && !of_property_read_bool(codec->dev->of_node, "adi,micbias-disable"))
+        snd_soc_dapm_add_routes(dapm, adau1977_micbias_routes, ARRAY_SIZE(adau1977_micbias_routes));
+
+    ret = adau19xx_profile_add_controls(codec);
+    if (ret)
+        dev_err(codec->dev, "failed to add Register Profile control: %d\n", ret);
+    return ret;
 }
 
 static int adau19xx_codec_probe(struct snd_soc_codec *codec) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("-----------------------------------\n");
-    pr_info("adau19xx:%s \n", __FUNCTION__);
+    dev_info(codec->dev, "-----------------------------------\n");
+    dev_info(codec->dev, "adau19xx:%s \n", __FUNCTION__);
 #endif
-    adau19xx_add_widgets(codec);
-    return 0;
+    struct adau1977 *adau19xx = snd_soc_codec_get_drvdata(codec);
+
+    adau19xx->codec = codec; //同步启动组解除静音时锁成员所在声卡的DAPM
+    return adau19xx_add_widgets(codec);
 }
 
 static int adau19xx_set_bias_level(struct snd_soc_codec *codec, enum snd_soc_bias_level level) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("-----------------------------------\n");
-    pr_info("adau19xx:%s \n", __FUNCTION__);
+    dev_info(codec->dev, "-----------------------------------\n");
+    dev_info(codec->dev, "adau19xx:%s \n", __FUNCTION__);
 #endif
     struct adau1977 *adau19xx = dev_get_drvdata(codec->dev);
+    ktime_t t = ktime_get();
+    unsigned int prev = adau19xx_phase_enter(adau19xx, ADAU19XX_PROF_BIAS_OFF + level);
+
     switch (level) {
         case SND_SOC_BIAS_ON:
 #ifdef CONFIG_ADAU19XX_DEBUG
-            pr_info("bias level = SND_SOC_BIAS_ON \n");
+            dev_info(codec->dev, "bias level = SND_SOC_BIAS_ON \n");
 #endif
-            if (adau19xx->sysclk_src == 0) {//MCLK
+            if (adau19xx->clk_src == ADAU19XX_SYSCLK_SRC_MCLK) {
                 mdelay(60); //防止噼啪声
+                adau19xx_prof_record(adau19xx, ADAU19XX_PROF_PLL_SETTLE, t);
             }
+            if (adau19xx->dc_cal_pending)
+                adau19xx_dc_cal_restore(adau19xx);
             break;
         case SND_SOC_BIAS_PREPARE:
 #ifdef CONFIG_ADAU19XX_DEBUG
-            pr_info("bias level = SND_SOC_BIAS_PREPARE \n");
+            dev_info(codec->dev, "bias level = SND_SOC_BIAS_PREPARE \n");
 #endif
             break;
         case SND_SOC_BIAS_STANDBY:
 #ifdef CONFIG_ADAU19XX_DEBUG
-            pr_info("bias level = SND_SOC_BIAS_STANDBY \n");
+            dev_info(codec->dev, "bias level = SND_SOC_BIAS_STANDBY \n");
 #endif
             break;
         case SND_SOC_BIAS_OFF:
 #ifdef CONFIG_ADAU19XX_DEBUG
-            pr_info("bias level = SND_SOC_BIAS_OFF \n");
+            dev_info(codec->dev, "bias level = SND_SOC_BIAS_OFF \n");
 #endif
             break;
     }
 
+    adau19xx_phase_exit(adau19xx, prev);
+    adau19xx_prof_record(adau19xx, ADAU19XX_PROF_BIAS_OFF + level, t);
+    adau19xx_res_set(adau19xx, ADAU19XX_RES_BIAS, level);
     return 0;
 }
 
@@ -800,9 +1617,9 @@ static unsigned int adau19xx_codec_read(struct snd_soc_codec *codec, unsigned in
     struct adau1977 *adau19xx = dev_get_drvdata(codec->dev);
     ret = regmap_read(adau19xx->regmap, reg, &value_r);
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("-----------------------------------\n");
-    pr_info("adau19xx:%s \n", __FUNCTION__);
-    adau19xx_print_msg(reg, ret, value_r);
+    dev_info(codec->dev, "-----------------------------------\n");
+    dev_info(codec->dev, "adau19xx:%s \n", __FUNCTION__);
+    adau19xx_print_msg(codec->dev, reg, ret, value_r);
 #endif
     return value_r;
 }
@@ -812,9 +1629,9 @@ static int adau19xx_codec_write(struct snd_soc_codec *codec, unsigned int reg, u
     struct adau1977 *adau19xx = dev_get_drvdata(codec->dev);
     ret = regmap_write(adau19xx->regmap, reg, val);
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("-----------------------------------\n");
-    pr_info("adau19xx:%s \n", __FUNCTION__);
-    adau19xx_print_msg(reg, ret, val);
+    dev_info(codec->dev, "-----------------------------------\n");
+    dev_info(codec->dev, "adau19xx:%s \n", __FUNCTION__);
+    adau19xx_print_msg(codec->dev, reg, ret, val);
 #endif
     return 0;
 }
@@ -827,115 +1644,184 @@ static const struct snd_soc_codec_driver adau19xx_soc_codec_driver = {
     .idle_bias_off = true,
 };
 
-//------------------------------------------------------------------------
-#ifdef CONFIG_ADAU19XX_DEBUG
-//调试用
-
-static ssize_t adau19xx_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count) {
-    pr_info("-----------------------------------\n");
-    pr_info("adau19xx:%s \n", __FUNCTION__);
-    adau19xx_do_store(dev, buf, count);
-    return count;
-}
-
-static ssize_t adau19xx_show(struct device *dev, struct device_attribute *attr, char *buf) {
-    pr_info("-----------------------------------\n");
-    pr_info("adau19xx:%s \n", __FUNCTION__);
-    adau19xx_do_show();
-}
-
-static DEVICE_ATTR(adau, 0664, adau19xx_show, adau19xx_store);
-
-static struct attribute * adau19xx_debug_attrs[] = {&dev_attr_adau.attr, NULL,};
-
-static struct attribute_group adau19xx_debug_attr_group = {
-    .name = "adau19xx_debug",
-    .attrs = adau19xx_debug_attrs,
+//各型号描述表,由I2C/SPI前端按匹配数据选取
+const struct adau19xx_variant adau19xx_variants[ADAU19XX_TYPE_NUM] = {
+    [ADAU1977] = {
+        .name = "adau1977",
+        .regmap_config = &adau1977_regmap_config,
+        .controls = adau1977_snd_controls,
+        .num_controls = ARRAY_SIZE(adau1977_snd_controls),
+        .widgets = adau1977_dapm_widgets,
+        .num_widgets = ARRAY_SIZE(adau1977_dapm_widgets),
+        .routes = adau1977_dapm_routes,
+        .num_routes = ARRAY_SIZE(adau1977_dapm_routes),
+        .has_micbias = true,
+    },
+    [ADAU1978] = {
+        .name = "adau1978",
+        .regmap_config = &adau1978_regmap_config,
+    },
+    [ADAU1979] = {
+        .name = "adau1979",
+        .regmap_config = &adau1978_regmap_config,
+    },
 };
-#endif
-//------------------------------------------------------------------------
+EXPORT_SYMBOL_GPL(adau19xx_variants);
 
-int adau19xx_probe(struct i2c_client *i2c, struct regmap *regmap, enum adau19xx_type type) {
+int adau19xx_probe(struct device *dev, struct regmap *regmap, enum adau19xx_type type,
+        struct adau19xx_bus *bus, void (*switch_mode)(struct device *dev)) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("-----------------------------------\n");
-    pr_info("adau19xx:%s \n", __FUNCTION__);
+    dev_info(dev, "-----------------------------------\n");
+    dev_info(dev, "adau19xx:%s \n", __FUNCTION__);
 #endif
     unsigned int power_off_mask;
+    struct reg_sequence *init_regs;
+    unsigned int num_init_regs, i;
+    u32 group_id;
     int ret = 0, val = 0;
     struct adau1977 *adau19xx;
-    struct device_node *np = i2c->dev.of_node;
-    adau19xx = devm_kzalloc(&i2c->dev, sizeof (*adau19xx), GFP_KERNEL);
+    struct device_node *np = dev->of_node;
+    adau19xx_reg_table_check();
+    //I2C/SPI前端都提供总线层,统计、跟踪、重试和绕过缓存的读取都依赖它
+    if (!bus) {
+        dev_err(dev, "no control bus\n");
+        return -EINVAL;
+    }
+    adau19xx = devm_kzalloc(dev, sizeof (*adau19xx), GFP_KERNEL);
     if (adau19xx == NULL) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-        pr_err("Unable to allocate adau private data\n");
+        dev_err(dev, "Unable to allocate adau private data\n");
 #endif
         return -ENOMEM;
     }
 
-    ret = of_property_read_u32(np, "sysclk-src", &val);
+    //经设备属性读取,没有设备树时(如adau19xx-emu创建的设备)也能提供
+    ret = device_property_read_u32(dev, "sysclk-src", &val);
     if (ret) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-        pr_err("Please set sysclk-src.\n");
+        dev_err(dev, "Please set sysclk-src.\n");
 #endif
         return -EINVAL;
     }
 
+    if (val < 0 || val > ADAU19XX_SYSCLK_SRC_AUTO) {
+        dev_err(dev, "invalid sysclk-src %d\n", val);
+        return -EINVAL;
+    }
+
     adau19xx->sysclk_src = val;
+    //自动模式下在第一次hw_params前按LRCLK处理
+    adau19xx->clk_src = val == ADAU19XX_SYSCLK_SRC_AUTO ? ADAU19XX_SYSCLK_SRC_LRCLK : val;
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("adau19xx->sysclk_src :%d\n", adau19xx->sysclk_src);
+    dev_info(dev, "adau19xx->sysclk_src :%d\n", adau19xx->sysclk_src);
 #endif
 
-    adau19xx->dev = &i2c->dev;
+    adau19xx->dev = dev;
     adau19xx->type = type;
+    adau19xx->variant = &adau19xx_variants[type];
     adau19xx->regmap = regmap;
+    adau19xx->bus = bus;
+    adau19xx->switch_mode = switch_mode;
     adau19xx->max_master_fs = 192000;
     adau19xx->constraints.list = adau19xx_rates;
     adau19xx->constraints.count = ARRAY_SIZE(adau19xx_rates);
 
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("i2c_id->driver_data :%d\n", type);
-    pr_info("i2c->name :%s\n", i2c->name);
-    pr_info("i2c->flags :%d\n", i2c->flags);
-    pr_info("i2c->addr :%d\n", i2c->addr);
-    pr_info("i2c->irq :%d\n", i2c->irq);
+    dev_info(dev, "type :%d\n", type);
+    dev_info(dev, "dev :%s\n", dev_name(dev));
 #endif
 
-    adau19xx->reset_gpio = devm_gpiod_get_optional(&i2c->dev, "reset", GPIOD_OUT_LOW);
+    adau19xx->reset_gpio = devm_gpiod_get_optional(dev, "reset", GPIOD_OUT_LOW);
     if (IS_ERR(adau19xx->reset_gpio)) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-        pr_err("adau19xx->reset_gpio read error!\n");
+        dev_err(dev, "adau19xx->reset_gpio read error!\n");
 #endif
         return PTR_ERR(adau19xx->reset_gpio);
     }
 #ifdef CONFIG_ADAU19XX_DEBUG
-    pr_info("adau19xx->reset_gpio=0x%x!\n", adau19xx->reset_gpio);
+    dev_info(dev, "adau19xx->reset_gpio=%p!\n", adau19xx->reset_gpio);
 #endif
 
-    dev_set_drvdata(&i2c->dev, adau19xx);
+    mutex_init(&adau19xx->lock);
+    spin_lock_init(&adau19xx->prof_lock);
+    spin_lock_init(&adau19xx->res_lock);
+    adau19xx->res.since = ktime_get_boottime();
+    INIT_DELAYED_WORK(&adau19xx->watchdog_work, adau19xx_watchdog_work);
+    of_property_read_u32(np, "adi,watchdog-ms", &adau19xx->watchdog_ms);
+    of_property_read_u32(np, "adi,bus-retries", &bus->retries);
+    if (bus->retries > ADAU19XX_BUS_RETRIES_MAX) {
+        dev_err(dev, "invalid adi,bus-retries %u, max %u\n", bus->retries, ADAU19XX_BUS_RETRIES_MAX);
+        return -EINVAL;
+    }
+
+    //主机模式最高采样率,受下游器件的BCLK上限限制时可调低
+    of_property_read_u32(np, "adi,max-master-fs", &adau19xx->max_master_fs);
+    if (adau19xx->max_master_fs < 8000 || adau19xx->max_master_fs > 192000) {
+        dev_err(dev, "invalid adi,max-master-fs %u\n", adau19xx->max_master_fs);
+        return -EINVAL;
+    }
+
+    dev_set_drvdata(dev, adau19xx);
+
+    ret = adau19xx_profile_of_init(adau19xx);
+    if (ret)
+        return ret;
+
+    ret = adau19xx_of_read_reg_seq(adau19xx, np, "adi,init-regs", &init_regs, &num_init_regs);
+    if (ret)
+        return ret;
+
+    if (num_init_regs) {
+        //仅写入缓存,随后power_enable中的regcache_sync一次性下发,注册声卡前即为最终配置
+        regcache_cache_only(regmap, true);
+        for (i = 0; i < num_init_regs; i++) {
+            ret = regmap_update_bits(regmap, init_regs[i].reg,
+                    ~adau19xx_reg_owned_bits(init_regs[i].reg) & 0xff, init_regs[i].def);
+            if (ret) {
+                dev_err(dev, "failed to apply adi,init-regs: %d\n", ret);
+                return ret;
+            }
+        }
+        //同步时跳过与默认值相同的寄存器,否则缓存中POWER的默认值0会在上电序列之后写回,芯片又被关断
+        regcache_mark_dirty(regmap);
+    }
 
     ret = adau19xx_power_enable(adau19xx);
     if (ret) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-        pr_err("power enable fail!\n");
+        dev_err(dev, "power enable fail!\n");
 #endif
         adau19xx_power_disable(adau19xx);
         return ret;
     }
 
-#ifdef CONFIG_ADAU19XX_DEBUG
-    //debug调试
-    ret = sysfs_create_group(&i2c->dev.kobj, &adau19xx_debug_attr_group);
-    if (ret) {
-        pr_err("failed to create attr adau\n");
-    } else {
-        pr_info("create sysfs OK in /sys/class/i2c-adapter/i2c-1/1-0071/adau_debug");
+    if (of_property_read_u32(np, "adi,sync-group", &group_id) == 0) {
+        ret = adau19xx_group_join(adau19xx, group_id);
+        if (ret)
+            return ret;
+        ret = devm_add_action_or_reset(dev, adau19xx_group_leave, adau19xx);
+        if (ret)
+            return ret;
     }
-#endif
 
-    ret = snd_soc_register_codec(&i2c->dev, &adau19xx_soc_codec_driver, &adau19xx_dai, 1);
+    if (adau19xx->watchdog_ms) {
+        ret = devm_add_action_or_reset(dev, adau19xx_watchdog_stop, adau19xx);
+        if (ret)
+            return ret;
+        schedule_delayed_work(&adau19xx->watchdog_work, msecs_to_jiffies(adau19xx->watchdog_ms));
+    }
+
+    ret = adau19xx_clk_init(adau19xx);
+    if (ret)
+        return ret;
+
+    //debugfs调试接口,创建失败不影响声卡工作
+    adau19xx_debugfs_init(adau19xx);
+
+    ret = snd_soc_register_codec(dev, &adau19xx_soc_codec_driver, &adau19xx_dai, 1);
     if (ret < 0) {
 #ifdef CONFIG_ADAU19XX_DEBUG
-        pr_err("Failed to register adau codec: %d\n", ret);
+        dev_err(dev, "Failed to register adau codec: %d\n", ret);
 #endif
     }
     return ret;
@@ -943,6 +1829,45 @@ int adau19xx_probe(struct i2c_client *i2c, struct regmap *regmap, enum adau19xx_
 
 EXPORT_SYMBOL_GPL(adau19xx_probe);
 
+#ifdef CONFIG_PM_SLEEP
+//系统休眠:power_disable会标记缓存为脏并切到cache only,休眠期间的控件修改只进缓存
+static int adau19xx_suspend(struct device *dev) {
+    struct adau1977 *adau19xx = dev_get_drvdata(dev);
+    int ret;
+
+    if (adau19xx->watchdog_ms)
+        cancel_delayed_work_sync(&adau19xx->watchdog_work);
+
+    mutex_lock(&adau19xx->lock);
+    ret = adau19xx_power_disable(adau19xx);
+    mutex_unlock(&adau19xx->lock);
+
+    return ret;
+}
+
+//唤醒:重新上电后regcache_sync只下发与默认值不同的寄存器,rbtree缓存按连续块合并写入
+static int adau19xx_resume(struct device *dev) {
+    struct adau1977 *adau19xx = dev_get_drvdata(dev);
+    int ret;
+
+    mutex_lock(&adau19xx->lock);
+    ret = adau19xx_power_enable(adau19xx);
+    mutex_unlock(&adau19xx->lock);
+    if (ret)
+        dev_err(dev, "resume failed: %d\n", ret);
+
+    if (adau19xx->watchdog_ms)
+        schedule_delayed_work(&adau19xx->watchdog_work, msecs_to_jiffies(adau19xx->watchdog_ms));
+
+    return ret;
+}
+#endif
+
+const struct dev_pm_ops adau19xx_pm_ops = {
+    SET_SYSTEM_SLEEP_PM_OPS(adau19xx_suspend, adau19xx_resume)
+};
+EXPORT_SYMBOL_GPL(adau19xx_pm_ops);
+
 MODULE_DESCRIPTION("ASoC ADAU19xx driver");
 MODULE_AUTHOR("Benjamin Wan<32132145@qq.com>");
 MODULE_LICENSE("GPL");
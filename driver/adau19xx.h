@@ -2,12 +2,39 @@
 #define _ADAU19XX_H
 #define CONFIG_ADAU19XX_DEBUG
 
+#ifdef CONFIG_COMMON_CLK
+#include <linux/clk-provider.h>
+#endif
+#include <linux/ktime.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
 #include <linux/regmap.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+#include <sound/soc.h>
 
 enum adau19xx_type {
     ADAU1977,
     ADAU1978,
     ADAU1979,
+    ADAU19XX_TYPE_NUM,
+};
+
+struct snd_kcontrol_new;
+struct snd_soc_dapm_widget;
+struct snd_soc_dapm_route;
+
+//型号描述:ADAU1978/1979没有升压转换器、MICBIAS和诊断寄存器
+struct adau19xx_variant {
+    const char *name;
+    const struct regmap_config *regmap_config;
+    const struct snd_kcontrol_new *controls; //在通用控件之外追加
+    unsigned int num_controls;
+    const struct snd_soc_dapm_widget *widgets;
+    unsigned int num_widgets;
+    const struct snd_soc_dapm_route *routes;
+    unsigned int num_routes;
+    bool has_micbias;
 };
 
 enum adau19xx_clk_id {
@@ -17,34 +44,9 @@ enum adau19xx_clk_id {
 enum adau19xx_sysclk_src {
     ADAU19XX_SYSCLK_SRC_MCLK,
     ADAU19XX_SYSCLK_SRC_LRCLK,
+    ADAU19XX_SYSCLK_SRC_AUTO, //每次hw_params按采样率和主从模式选择
 };
 
-struct adau1977 {
-    struct regmap *regmap;
-    bool right_j;
-    unsigned int sysclk;
-    enum adau19xx_sysclk_src sysclk_src;
-    struct gpio_desc *reset_gpio;
-    enum adau19xx_type type;
-
-    struct snd_pcm_hw_constraint_list constraints;
-
-    struct device *dev;
-
-    unsigned int max_master_fs;
-    unsigned int slot_width;
-    bool enabled;
-    bool master;
-};
-extern void adau19xx_print_msg(u8 reg, int ret, int value);
-extern void adau19xx_do_store(struct device *dev, const char *buf, size_t count);
-extern void adau19xx_do_show(void);
-extern int adau19xx_probe(struct i2c_client *i2c, struct regmap *regmap, enum adau19xx_type type);
-
-#define ADAU19XX_CHANNELS_MAX  2  //range[1, 4],but we run in sum mode 2
-#define ADAU19XX_RATES    SNDRV_PCM_RATE_KNOT
-#define ADAU19XX_FORMATS   (SNDRV_PCM_FMTBIT_S16_LE | SNDRV_PCM_FMTBIT_S32_LE)
-
 //寄存器汇总
 #define ADAU19XX_REG_POWER  0x00 //主电源和软件复位寄存器
 #define ADAU19XX_REG_PLL  0x01//PLL控制寄存器
@@ -69,8 +71,320 @@ extern int adau19xx_probe(struct i2c_client *i2c, struct regmap *regmap, enum ad
 
 //other in tool
 #define ADAU19XX_REG_ADC_BIAS_CONTROL 0x0f //未知
-#define ADAU19XX_REG_TWEAK1 0x1b//升压转换器电压控制
-#define ADAU19XX_REG_ADC_TWEAK 0x2c//未知
+#define ADAU19XX_REG_TWEAK1 0x1b//升压转换器电压控制,超出max_register,驱动不访问
+#define ADAU19XX_REG_ADC_TWEAK 0x2c//未知,超出max_register,驱动不访问
+
+#define ADAU19XX_NUM_REGS (ADAU19XX_REG_DC_HPF_CAL + 1)
+
+//控制总线统计
+enum adau19xx_bus_op {
+    ADAU19XX_BUS_OP_READ,
+    ADAU19XX_BUS_OP_WRITE,
+    ADAU19XX_BUS_OP_NUM,
+};
+
+#define ADAU19XX_BUS_HIST_BUCKETS 16 //第i个桶:[2^(i-1), 2^i)us,第0个桶<1us
+
+struct adau19xx_bus_stats {
+    spinlock_t lock;
+    u32 reads[ADAU19XX_NUM_REGS]; //按寄存器计,连续读写中每个寄存器各计一次
+    u32 writes[ADAU19XX_NUM_REGS];
+    u32 failures[ADAU19XX_NUM_REGS]; //重试用尽后仍失败,按传输的起始寄存器计
+    u64 bytes[ADAU19XX_BUS_OP_NUM]; //数据字节数,不含寄存器地址
+    u32 xfers[ADAU19XX_BUS_OP_NUM];
+    u64 total_ns[ADAU19XX_BUS_OP_NUM];
+    u32 hist[ADAU19XX_BUS_OP_NUM][ADAU19XX_BUS_HIST_BUCKETS];
+    u32 retries[ADAU19XX_BUS_OP_NUM]; //重试次数
+    u32 retry_ok[ADAU19XX_BUS_OP_NUM]; //经重试后成功的传输数
+    u32 recoveries; //总线恢复成功次数
+    u32 recovery_failures;
+};
+
+//总线出错重试:退避时间从MIN开始每次翻倍,不超过MAX
+#define ADAU19XX_BUS_RETRIES 3 //默认重试次数,可由dts属性adi,bus-retries修改,0=不重试
+#define ADAU19XX_BUS_RETRIES_MAX 8 //adi,bus-retries上限,退避已封顶,更多次重试只会拖长出错时的阻塞时间
+#define ADAU19XX_BUS_RETRY_MIN_US 100
+#define ADAU19XX_BUS_RETRY_MAX_US 5000
+
+//具体总线(I2C/SPI)只需实现收发,计时统计等由adau19xx-bus.c统一处理
+struct adau19xx_bus_ops {
+    int (*write)(void *context, const void *data, size_t count);
+    int (*read)(void *context, const void *reg, size_t reg_size, void *val, size_t val_size);
+    int (*recover)(void *context); //可选:总线卡死(超时)时恢复总线
+};
+
+//寄存器操作飞行记录器:固定大小环形缓冲,写入无锁,可常开
+//phase和old_val是尽力而为的诊断信息,不保证精确:
+//  phase为整条总线共用的当前阶段,在每次操作开始时取一次;不同上下文(如看门狗与DAPM)
+//  同时访问时,后设置的阶段会被记到另一方的操作上
+//  old_val来自影子表,regmap之外的硬件读取(看门狗、debugfs)可能与regmap的读写交错更新影子表
+#define ADAU19XX_TRACE_ENTRIES 256 //必须为2的幂
+#define ADAU19XX_TRACE_DUMP_ON_FAULT 32 //检测到故障时打印到内核日志的条数
+
+struct adau19xx_trace_entry {
+    u32 seq; //写入序号+1,最后写入;为0或与预期不符表示该条正在写或已被覆盖
+    u8 op; //enum adau19xx_bus_op
+    u8 reg;
+    u8 old_val; //此前在总线上见到的值
+    u8 new_val;
+    u8 phase; //enum adau19xx_prof_phase,ADAU19XX_PROF_NUM表示空闲
+    s16 result;
+    u64 ts_ns;
+};
+
+struct adau19xx_trace {
+    atomic_t head;
+    u8 shadow[ADAU19XX_NUM_REGS];
+    struct adau19xx_trace_entry ring[ADAU19XX_TRACE_ENTRIES];
+};
+
+struct adau19xx_bus {
+    const struct adau19xx_bus_ops *ops;
+    void *context;
+    unsigned int reg_bytes; //寄存器地址占用字节数,寄存器地址在最后一个字节
+    u8 read_flag_mask; //读操作时或到第一个字节,与regmap_config.read_flag_mask一致
+    unsigned int phase; //当前调用阶段,写入飞行记录;多个上下文共用,仅供参考
+    unsigned int retries; //出错后的最大重试次数
+    struct adau19xx_bus_stats stats;
+    struct adau19xx_trace trace;
+};
+
+//打开录音流各阶段耗时统计
+enum adau19xx_prof_phase {
+    ADAU19XX_PROF_STARTUP,
+    ADAU19XX_PROF_SYSCLK,
+    ADAU19XX_PROF_SET_FMT,
+    ADAU19XX_PROF_HW_PARAMS,
+    ADAU19XX_PROF_BIAS_OFF, //以下4项顺序与enum snd_soc_bias_level一致
+    ADAU19XX_PROF_BIAS_STANDBY,
+    ADAU19XX_PROF_BIAS_PREPARE,
+    ADAU19XX_PROF_BIAS_ON,
+    ADAU19XX_PROF_PLL_SETTLE, //MCLK模式下等待PLL稳定
+    ADAU19XX_PROF_UNMUTE,
+    ADAU19XX_PROF_STREAM_OPEN, //startup到解除静音的总耗时
+    ADAU19XX_PROF_POWER_UP, //adau19xx_power_enable
+    ADAU19XX_PROF_RECOVER, //看门狗故障恢复
+    ADAU19XX_PROF_NUM,
+};
+
+#define ADAU19XX_PROF_SAMPLES 128 //保留最近的样本用于计算p99
+
+struct adau19xx_prof_stats {
+    u32 count;
+    u64 total_ns;
+    u64 min_ns;
+    u64 max_ns;
+    u32 samples_us[ADAU19XX_PROF_SAMPLES];
+};
+
+//上电流程各阶段,用于统计耗时
+enum adau19xx_pwr_phase {
+    ADAU19XX_PWR_PHASE_GPIO, //释放硬复位
+    ADAU19XX_PWR_PHASE_RESET, //软件复位+主机上电
+    ADAU19XX_PWR_PHASE_SYNC, //regcache_sync
+    ADAU19XX_PWR_PHASE_PLL, //PLL重写
+    ADAU19XX_PWR_PHASE_NUM,
+};
+
+//时钟主机模式下对外提供的时钟
+enum adau19xx_clk_out {
+    ADAU19XX_CLK_OUT_BCLK,
+    ADAU19XX_CLK_OUT_LRCLK,
+    ADAU19XX_CLK_OUT_NUM,
+};
+
+struct adau19xx_clk {
+#ifdef CONFIG_COMMON_CLK
+    struct clk_hw hw;
+#endif
+    unsigned long rate; //由hw_params更新,0=未输出
+};
+
+//各电源状态停留时间统计
+enum adau19xx_res_item {
+    ADAU19XX_RES_BIAS, //value=enum snd_soc_bias_level
+    ADAU19XX_RES_POWERED, //value=0/1
+    ADAU19XX_RES_ADCS, //value=+1/-1,已上电ADC数变化
+    ADAU19XX_RES_BOOST, //value=0/1
+    ADAU19XX_RES_MICBIAS, //value=0/1
+};
+
+#define ADAU19XX_RES_BIAS_LEVELS 4 //SND_SOC_BIAS_OFF~SND_SOC_BIAS_ON
+#define ADAU19XX_RES_MAX_ADCS 4
+
+struct adau19xx_residency {
+    ktime_t since; //上次结算时间,用CLOCK_BOOTTIME,系统挂起期间也计入
+    unsigned int bias;
+    bool powered;
+    bool boost;
+    bool micbias;
+    unsigned int num_adcs;
+
+    u64 bias_ns[ADAU19XX_RES_BIAS_LEVELS];
+    u32 bias_enters[ADAU19XX_RES_BIAS_LEVELS];
+    u64 powered_ns;
+    u64 off_ns;
+    u32 power_ups;
+    u64 adcs_ns[ADAU19XX_RES_MAX_ADCS + 1]; //按同时上电的ADC数
+    u64 boost_ns;
+    u64 micbias_ns;
+};
+
+//命名寄存器配置
+#define ADAU19XX_MAX_PROFILES 8
+#define ADAU19XX_PROFILE_NAME_LEN 32
+
+struct adau19xx_profile {
+    char name[ADAU19XX_PROFILE_NAME_LEN];
+    struct reg_sequence *regs; //按寄存器地址排序
+    unsigned int num_regs;
+};
+
+//多芯片同步启动组,成员由设备树adi,sync-group指定
+struct adau19xx_group {
+    struct list_head list;
+    u32 id;
+    struct list_head members;
+    unsigned int num_members;
+    unsigned int num_active; //有打开音频流的成员数,只等待这些成员
+    unsigned int num_armed; //已请求解除静音的成员数(含已解除的)
+    struct delayed_work release_work; //超时后不再等待未就绪的成员
+};
+
+struct adau1977 {
+    struct regmap *regmap;
+    struct adau19xx_bus *bus; //I2C/SPI前端提供,不为NULL
+    void (*switch_mode)(struct device *dev); //SPI:复位后切换到SPI控制模式
+    bool right_j;
+    unsigned int sysclk;
+    enum adau19xx_sysclk_src sysclk_src; //dts配置
+    enum adau19xx_sysclk_src clk_src; //当前实际使用的PLL时钟源
+    unsigned int mclk_mask; //MCLK可产生的采样率
+    struct gpio_desc *reset_gpio;
+    enum adau19xx_type type;
+    const struct adau19xx_variant *variant;
+
+    struct snd_pcm_hw_constraint_list constraints;
+
+    struct device *dev;
+    struct snd_soc_codec *codec; //codec probe后有效
+
+    unsigned int max_master_fs;
+    unsigned int slot_width;
+    bool enabled;
+    bool master;
+    bool dc_cal_done; //已执行过直流校准,复位后需重新校准
+    bool dc_cal_pending; //复位丢失了校准结果,下次打开音频流时补做
+    unsigned int pwr_phase_us[ADAU19XX_PWR_PHASE_NUM]; //最近一次上电各阶段耗时
+
+    struct mutex lock; //串行化上电流程、绕过缓存的读写和故障恢复
+    struct delayed_work watchdog_work;
+    unsigned int watchdog_ms; //故障看门狗周期,0=关闭
+    unsigned int wdt_checks;
+    unsigned int wdt_recoveries;
+
+    spinlock_t res_lock;
+    struct adau19xx_residency res;
+
+    spinlock_t prof_lock;
+    struct adau19xx_prof_stats prof[ADAU19XX_PROF_NUM];
+    ktime_t stream_start;
+
+    struct adau19xx_group *group; //NULL=不参与同步启动
+    struct list_head group_node;
+    bool group_active; //startup~shutdown之间
+    bool group_armed; //已请求解除静音
+    bool group_running; //已随全组解除静音
+
+    struct adau19xx_clk clk_out[ADAU19XX_CLK_OUT_NUM];
+
+    struct adau19xx_profile profiles[ADAU19XX_MAX_PROFILES];
+    unsigned int num_profiles;
+    unsigned int cur_profile; //最后一次应用的配置,0=无,i=profiles[i-1]
+    const char *profile_texts[ADAU19XX_MAX_PROFILES + 1];
+    struct soc_enum profile_enum;
+    bool profiles_fixed; //Register Profile控件已注册,配置个数和名称不再变化
+
+    struct dentry *debugfs; //debugfs目录
+    bool debugfs_dump_cache; //registers中同时列出缓存值
+};
+extern const u8 adau19xx_reg_flags[ADAU19XX_NUM_REGS];
+extern const char *adau19xx_reg_name(unsigned int reg);
+extern void adau19xx_print_msg(struct device *dev, u8 reg, int ret, int value);
+extern int adau19xx_hw_bulk_read(struct adau1977 *adau19xx, unsigned int reg, u8 *buf, size_t count);
+extern void adau19xx_debugfs_init(struct adau1977 *adau19xx);
+extern int adau19xx_profile_set(struct adau1977 *adau19xx, const char *name,
+        struct reg_sequence *regs, unsigned int num);
+extern int adau19xx_profile_of_init(struct adau1977 *adau19xx);
+extern int adau19xx_profile_add_controls(struct snd_soc_codec *codec);
+extern int adau19xx_clk_init(struct adau1977 *adau19xx);
+extern void adau19xx_clk_set_rates(struct adau1977 *adau19xx, unsigned long bclk, unsigned long lrclk);
+extern void adau19xx_res_set(struct adau1977 *adau19xx, enum adau19xx_res_item item, int value);
+extern void adau19xx_prof_record(struct adau1977 *adau19xx, enum adau19xx_prof_phase phase, ktime_t start);
+struct device_node;
+extern int adau19xx_of_read_reg_seq(struct adau1977 *adau19xx, struct device_node *np, const char *propname,
+        struct reg_sequence **seq, unsigned int *num);
+extern const struct dev_pm_ops adau19xx_pm_ops;
+extern struct adau19xx_bus *adau19xx_bus_alloc(struct device *dev, const struct adau19xx_bus_ops *ops,
+        void *context, unsigned int reg_bytes);
+extern struct regmap *adau19xx_bus_regmap_init(struct device *dev, struct adau19xx_bus *bus,
+        const struct regmap_config *config);
+extern void adau19xx_bus_stats_reset(struct adau19xx_bus *bus);
+extern int adau19xx_bus_hw_read(struct adau19xx_bus *bus, unsigned int reg, u8 *buf, size_t count);
+extern void adau19xx_trace_dump(struct adau19xx_bus *bus, struct device *dev, unsigned int count);
+extern unsigned int adau19xx_trace_snapshot(struct adau19xx_bus *bus, struct adau19xx_trace_entry *out,
+        unsigned int count);
+extern const struct adau19xx_variant adau19xx_variants[ADAU19XX_TYPE_NUM];
+extern int adau19xx_probe(struct device *dev, struct regmap *regmap, enum adau19xx_type type,
+        struct adau19xx_bus *bus, void (*switch_mode)(struct device *dev));
+
+#define ADAU19XX_CHANNELS_MAX  2  //range[1, 4],but we run in sum mode 2
+#define ADAU19XX_RATES    SNDRV_PCM_RATE_KNOT
+#define ADAU19XX_FORMATS   (SNDRV_PCM_FMTBIT_S16_LE | SNDRV_PCM_FMTBIT_S32_LE)
+
+//寄存器属性
+#define ADAU19XX_REG_F_R BIT(0) //可读
+#define ADAU19XX_REG_F_W BIT(1) //可写
+#define ADAU19XX_REG_F_VOLATILE BIT(2) //不缓存
+#define ADAU19XX_REG_F_1977 BIT(3) //仅ADAU1977有
+
+//寄存器描述表中的类型
+#define ADAU19XX_REG_F_RW (ADAU19XX_REG_F_R | ADAU19XX_REG_F_W) //有默认值,缓存
+#define ADAU19XX_REG_F_RW77 (ADAU19XX_REG_F_RW | ADAU19XX_REG_F_1977)
+#define ADAU19XX_REG_F_RO (ADAU19XX_REG_F_R | ADAU19XX_REG_F_VOLATILE) //只读状态
+#define ADAU19XX_REG_F_RO77 (ADAU19XX_REG_F_RO | ADAU19XX_REG_F_1977)
+#define ADAU19XX_REG_F_RSV (ADAU19XX_REG_F_RW | ADAU19XX_REG_F_VOLATILE) //未公开,默认值未知,不缓存
+
+//寄存器描述表:reg_defaults、可读/可写/易失规则和寄存器名都由此生成,新增寄存器只改这里
+//X(地址, 名称, 默认值, 类型),每个地址0x00~0x1a必须且只能出现一次
+#define ADAU19XX_REG_TABLE(X) \
+    X(ADAU19XX_REG_POWER, "POWER", 0x00, RW) \
+    X(ADAU19XX_REG_PLL, "PLL", 0x41, RW) \
+    X(ADAU19XX_REG_BOOST, "BOOST", 0x4a, RW77) \
+    X(ADAU19XX_REG_MICBIAS, "MICBIAS", 0x7d, RW77) \
+    X(ADAU19XX_REG_BLOCK_POWER_SAI, "BLOCK_POWER_SAI", 0x3d, RW) \
+    X(ADAU19XX_REG_SAI_CTRL0, "SAI_CTRL0", 0x02, RW) \
+    X(ADAU19XX_REG_SAI_CTRL1, "SAI_CTRL1", 0x00, RW) \
+    X(ADAU19XX_REG_CMAP12, "CMAP12", 0x10, RW) \
+    X(ADAU19XX_REG_CMAP34, "CMAP34", 0x32, RW) \
+    X(ADAU19XX_REG_SAI_OVERTEMP, "SAI_OVERTEMP", 0xf0, RW) \
+    X(ADAU19XX_REG_POST_ADC_GAIN(0), "POST_ADC_GAIN(0)", 0xa0, RW) \
+    X(ADAU19XX_REG_POST_ADC_GAIN(1), "POST_ADC_GAIN(1)", 0xa0, RW) \
+    X(ADAU19XX_REG_POST_ADC_GAIN(2), "POST_ADC_GAIN(2)", 0xa0, RW) \
+    X(ADAU19XX_REG_POST_ADC_GAIN(3), "POST_ADC_GAIN(3)", 0xa0, RW) \
+    X(ADAU19XX_REG_MISC_CONTROL, "MISC_CONTROL", 0x02, RW) \
+    X(ADAU19XX_REG_ADC_BIAS_CONTROL, "ADC_BIAS_CONTROL", 0x00, RSV) \
+    X(ADAU19XX_REG_DIAG_CONTROL, "DIAG_CONTROL", 0x0f, RW77) \
+    X(ADAU19XX_REG_STATUS(0), "STATUS(0)", 0x00, RO77) \
+    X(ADAU19XX_REG_STATUS(1), "STATUS(1)", 0x00, RO77) \
+    X(ADAU19XX_REG_STATUS(2), "STATUS(2)", 0x00, RO77) \
+    X(ADAU19XX_REG_STATUS(3), "STATUS(3)", 0x00, RO77) \
+    X(ADAU19XX_REG_DIAG_IRQ1, "DIAG_IRQ1", 0x20, RW77) \
+    X(ADAU19XX_REG_DIAG_IRQ2, "DIAG_IRQ2", 0x00, RW77) \
+    X(ADAU19XX_REG_ADJUST1, "ADJUST1", 0x00, RW77) \
+    X(ADAU19XX_REG_ADJUST2, "ADJUST2", 0x00, RW77) \
+    X(ADAU19XX_REG_ADC_CLIP, "ADC_CLIP", 0x00, RO) \
+    X(ADAU19XX_REG_DC_HPF_CAL, "DC_HPF_CAL", 0x00, RW)
 
 //0x00 主电源和软件复位寄存器
 #define ADAU19XX_POWER_RESET   BIT(7)//软件复位 0=正常工作 1=软件复位
@@ -100,10 +414,19 @@ extern int adau19xx_probe(struct i2c_client *i2c, struct regmap *regmap, enum ad
 
 #define ADAU19XX_MICBIAS_OC_EN BIT(1)//过流故障保护 0=disable 1=enable
 
+//0x03 MICBIAS和升压控制寄存器
+#define ADAU19XX_MICBIAS_MB_EN_SHIFT 3
+#define ADAU19XX_MICBIAS_MB_EN BIT(ADAU19XX_MICBIAS_MB_EN_SHIFT)//MICBIAS使能 0=off 1=on
+#define ADAU19XX_MICBIAS_BOOST_EN_SHIFT 2
+#define ADAU19XX_MICBIAS_BOOST_EN BIT(ADAU19XX_MICBIAS_BOOST_EN_SHIFT)//升压转换器使能 0=off 1=on
+#define ADAU19XX_MICBIAS_BOOST_RECOV BIT(0)//升压故障恢复模式 0=自动 1=手动
+
 //0x04 模块电源控制和串行端口控制寄存器
 #define ADAU19XX_BLOCK_POWER_SAI_LR_POL  BIT(7)//设置LRCLK极性 0=LRCLK先低后高 1=LRCLK先高后低
 #define ADAU19XX_BLOCK_POWER_SAI_BCLK_EDGE BIT(6)//设置数据改变的位时钟边沿 0=数据在下降沿改变 1=数据在上升沿改变
 #define ADAU19XX_BLOCK_POWER_SAI_LDO_EN  BIT(5)//LDO调机器使能 0=LDO关断 1=LDO使能
+#define ADAU19XX_BLOCK_POWER_SAI_VREF_EN BIT(4)//基准电压使能,由DAPM控制
+#define ADAU19XX_BLOCK_POWER_SAI_ADC_EN_MASK 0x0f//ADC通道1~4使能,由DAPM控制
 
 //0x05 串行端口控制寄存器1
 #define ADAU19XX_SAI_CTRL0_FMT_MASK  (0x3 << 6)//串行数据格式
@@ -147,6 +470,7 @@ extern int adau19xx_probe(struct i2c_client *i2c, struct regmap *regmap, enum ad
 
 //0x0e MMUTE 主静音
 #define ADAU19XX_MISC_CONTROL_MMUTE  BIT(4) //主静音 0=正常工作 1=所有通道静音
+#define ADAU19XX_MISC_CONTROL_DC_CAL  BIT(0) //直流校准 0=正常工作 1=执行直流校准,完成后自动清零
 #define ADAU19XX_MISC_CONTROL_SUM_MODE_MASK (0x3 << 6)//实现较高SNR信噪比的通道求和模式控制
 #define ADAU19XX_MISC_CONTROL_SUM_MODE_4 (0x0 << 6)//4通道正常工作
 #define ADAU19XX_MISC_CONTROL_SUM_MODE_2 (0x1 << 6)//2通道求和工作
@@ -156,11 +480,114 @@ extern int adau19xx_probe(struct i2c_client *i2c, struct regmap *regmap, enum ad
 #define ADAU19XX_CHAN_MAP_SECOND_SLOT_OFFSET 4
 #define ADAU19XX_CHAN_MAP_FIRST_SLOT_OFFSET 0
 
+//上电流程延时(us)
+#define ADAU19XX_RESET_GPIO_DELAY_US 200 //释放RESET引脚后等待内部上电复位完成
+//数据手册没有给出软件复位所需时间,复位位自动清零;I2C下写PWUP本身要几十微秒,SPI只要几微秒,
+//留10us余量,保证寄存器恢复默认值后再写PWUP,不依赖总线速度
+#define ADAU19XX_SOFT_RESET_DELAY_US 10
+#define ADAU19XX_PWUP_DELAY_US 100 //主机上电后等待LDO与基准电压建立
+
+//故障看门狗签名:POWER、PLL和SAI_CTRL0,按寄存器地址存放在POWER~SAI_CTRL0的缓冲区中
+#define ADAU19XX_WDT_SIG_FIRST ADAU19XX_REG_POWER
+#define ADAU19XX_WDT_SIG_NUM (ADAU19XX_REG_SAI_CTRL0 - ADAU19XX_REG_POWER + 1)
+
+//直流校准轮询间隔与超时
+#define ADAU19XX_MICBIAS_SETTLE_MS 10 //LRCLK模式下MICBIAS开启后等待输出稳定
+#define ADAU19XX_GROUP_SYNC_TIMEOUT_MS 200 //组内已有成员就绪后,等待其他打开音频流的成员的最长时间
+#define ADAU19XX_DC_CAL_POLL_US 1000
+#define ADAU19XX_DC_CAL_TIMEOUT_US 100000
+
 #define ADAU19XX_RATE_CONSTRAINT_MASK_32000 0x001f
 #define ADAU19XX_RATE_CONSTRAINT_MASK_44100 0x03e0
 #define ADAU19XX_RATE_CONSTRAINT_MASK_48000 0x7c00
 /* All rates >= 32000 */
 #define ADAU19XX_RATE_CONSTRAINT_MASK_LRCLK 0x739c
 
-#endif
+//设置当前调用阶段,返回之前的阶段用于恢复
+static inline unsigned int adau19xx_phase_enter(struct adau1977 *adau19xx, unsigned int phase) {
+    unsigned int prev = READ_ONCE(adau19xx->bus->phase);
+
+    WRITE_ONCE(adau19xx->bus->phase, phase);
+    return prev;
+}
+
+static inline void adau19xx_phase_exit(struct adau1977 *adau19xx, unsigned int prev) {
+    WRITE_ONCE(adau19xx->bus->phase, prev);
+}
+
+//以下为不依赖设备状态的计算,driver/test在主机上直接测试
 
+//驱动其他部分独占的位:上电/复位由上电流程控制,电源使能由DAPM控制,
+//静音由DAI/同步组控制,直流校准由校准控件触发;dts和debugfs的寄存器列表不能改写这些位
+static inline unsigned int adau19xx_reg_owned_bits(unsigned int reg) {
+    switch (reg) {
+        case ADAU19XX_REG_POWER:
+            return 0xff;
+        case ADAU19XX_REG_MICBIAS:
+            return ADAU19XX_MICBIAS_MB_EN | ADAU19XX_MICBIAS_BOOST_EN;
+        case ADAU19XX_REG_BLOCK_POWER_SAI:
+            return ADAU19XX_BLOCK_POWER_SAI_VREF_EN | ADAU19XX_BLOCK_POWER_SAI_ADC_EN_MASK;
+        case ADAU19XX_REG_MISC_CONTROL:
+            return ADAU19XX_MISC_CONTROL_MMUTE | ADAU19XX_MISC_CONTROL_DC_CAL;
+        default:
+            return 0;
+    }
+}
+
+//MCLK是否为base_freq * 128的1/2/3/4/6倍,即PLL能否由它锁定
+static inline bool adau19xx_check_sysclk(unsigned int mclk, unsigned int base_freq) {
+    unsigned int mcs;
+
+    if (mclk % (base_freq * 128) != 0)
+        return false;
+
+    mcs = mclk / (128 * base_freq);
+    if (mcs < 1 || mcs > 6 || mcs == 5)
+        return false;
+
+    return true;
+}
+
+//采样率对应的SAI_CTRL0 FS字段
+static inline int adau19xx_lookup_fs(unsigned int rate) {
+    if (rate >= 8000 && rate <= 12000)
+        return ADAU19XX_SAI_CTRL0_FS_8000_12000;
+    else if (rate >= 16000 && rate <= 24000)
+        return ADAU19XX_SAI_CTRL0_FS_16000_24000;
+    else if (rate >= 32000 && rate <= 48000)
+        return ADAU19XX_SAI_CTRL0_FS_32000_48000;
+    else if (rate >= 64000 && rate <= 96000)
+        return ADAU19XX_SAI_CTRL0_FS_64000_96000;
+    else if (rate >= 128000 && rate <= 192000)
+        return ADAU19XX_SAI_CTRL0_FS_128000_192000;
+
+    return -EINVAL;
+}
+
+//MCLK模式下PLL的MCS字段,fs为adau19xx_lookup_fs的结果
+static inline int adau19xx_calc_mcs(unsigned int sysclk, unsigned int rate, unsigned int fs) {
+    unsigned int mcs;
+
+    /*
+     * rate = sysclk / (512 * mcs_lut[mcs]) * 2**fs
+     * => mcs_lut[mcs] = sysclk / (512 * rate) * 2**fs
+     * => mcs_lut[mcs] = sysclk / ((512 / 2**fs) * rate)
+     */
+    rate *= 512 >> fs;
+    if (sysclk % rate != 0)
+        return -EINVAL;
+
+    mcs = sysclk / rate;
+
+    /* The factors configured by MCS are 1, 2, 3, 4, 6 */
+    if (mcs < 1 || mcs > 6 || mcs == 5)
+        return -EINVAL;
+
+    mcs = mcs - 1;
+    if (mcs == 5)
+        mcs = 4;
+
+    return mcs;
+}
+
+#endif
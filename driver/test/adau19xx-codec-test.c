@@ -0,0 +1,669 @@
+//adau19xx.c的主机集成测试:probe、set_fmt、hw_params、上下电、直流校准和同步启动组
+//直接包含adau19xx.c以调用其中的静态函数;regmap由adau19xx-host.c按内核行为实现,芯片寄存器模型在本文件
+//每步操作后检查芯片寄存器映像、缓存和总线传输次数,不需要内核源码和芯片
+//  make -C driver/test
+//  ADAU19XX_TEST_VERBOSE=1 ./adau19xx-codec-test   //同时打印驱动的警告和错误
+
+#define CONFIG_PM_SLEEP
+
+#include <stdio.h>
+#include <string.h>
+
+#include "adau19xx.c"
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+    } \
+} while (0)
+
+//其他源文件中的函数:只保留测试需要观察的部分
+static unsigned long test_bclk, test_lrclk;
+
+int adau19xx_bus_hw_read(struct adau19xx_bus *bus, unsigned int reg, u8 *buf, size_t count) {
+    return host_regmap_hw_read(bus->context, reg, buf, count);
+}
+
+void adau19xx_trace_dump(struct adau19xx_bus *bus, struct device *dev, unsigned int count) {
+}
+
+void adau19xx_res_set(struct adau1977 *adau19xx, enum adau19xx_res_item item, int value) {
+}
+
+void adau19xx_prof_record(struct adau1977 *adau19xx, enum adau19xx_prof_phase phase, ktime_t start) {
+}
+
+void adau19xx_print_msg(struct device *dev, u8 reg, int ret, int value) {
+}
+
+void adau19xx_debugfs_init(struct adau1977 *adau19xx) {
+}
+
+int adau19xx_clk_init(struct adau1977 *adau19xx) {
+    return 0;
+}
+
+void adau19xx_clk_set_rates(struct adau1977 *adau19xx, unsigned long bclk, unsigned long lrclk) {
+    test_bclk = bclk;
+    test_lrclk = lrclk;
+}
+
+int adau19xx_profile_of_init(struct adau1977 *adau19xx) {
+    return 0;
+}
+
+int adau19xx_profile_add_controls(struct snd_soc_codec *codec) {
+    return 0;
+}
+
+//芯片寄存器模型,与adau19xx-emu相同:写RESET恢复默认值;另外DC_CAL写入后立即完成并清零
+#define TEST_HW_DEFAULT(reg, name, def, kind) [reg] = def,
+
+static const u8 test_hw_defaults[ADAU19XX_NUM_REGS] = {
+    ADAU19XX_REG_TABLE(TEST_HW_DEFAULT)
+};
+
+static unsigned int test_calibrations;
+static bool test_dc_cal_stuck; //校准不结束,用于测试超时
+
+static void test_chip_reset(struct regmap *map) {
+    memset(map->hw, 0, sizeof (map->hw));
+    memcpy(map->hw, test_hw_defaults, sizeof (test_hw_defaults));
+}
+
+static void test_chip_write(struct regmap *map, unsigned int reg, unsigned int val) {
+    if (reg == ADAU19XX_REG_POWER && (val & ADAU19XX_POWER_RESET)) {
+        test_chip_reset(map);
+        return;
+    }
+    if (reg == ADAU19XX_REG_MISC_CONTROL && (val & ADAU19XX_MISC_CONTROL_DC_CAL)) {
+        test_calibrations++;
+        if (!test_dc_cal_stuck)
+            val &= ~ADAU19XX_MISC_CONTROL_DC_CAL;
+    }
+    map->hw[reg] = val;
+}
+
+//一个codec实例:设备、总线、regmap,以及probe后创建的codec/dai和一条录音流
+struct test_codec {
+    struct device dev;
+    struct device_node np;
+    struct adau19xx_bus bus;
+    struct regmap *map;
+    struct adau1977 *adau19xx;
+    struct snd_soc_codec codec;
+    struct snd_soc_dai dai;
+    struct snd_pcm_runtime runtime;
+    struct snd_pcm_substream substream;
+};
+
+static struct snd_soc_card test_card;
+
+static const u32 test_src_mclk[] = { ADAU19XX_SYSCLK_SRC_MCLK };
+static const u32 test_src_lrclk[] = { ADAU19XX_SYSCLK_SRC_LRCLK };
+
+static const struct host_property test_props_lrclk[] = {
+    { "sysclk-src", test_src_lrclk, 1 },
+    { NULL },
+};
+
+static const struct host_property test_props_mclk[] = {
+    { "sysclk-src", test_src_mclk, 1 },
+    { NULL },
+};
+
+static int test_probe(struct test_codec *t, const char *name, enum adau19xx_type type,
+        const struct host_property *props) {
+    int ret;
+
+    memset(t, 0, sizeof (*t));
+    t->dev.name = name;
+    t->np.props = props;
+    t->dev.of_node = &t->np;
+    t->map = host_regmap_init(&t->dev, adau19xx_variants[type].regmap_config);
+    t->map->hw_write = test_chip_write;
+    test_chip_reset(t->map);
+    t->bus.context = t->map;
+    t->bus.phase = ADAU19XX_PROF_NUM;
+
+    host_num_codecs = 0;
+    ret = adau19xx_probe(&t->dev, t->map, type, &t->bus, NULL);
+    if (ret)
+        return ret;
+    t->adau19xx = dev_get_drvdata(&t->dev);
+    if (host_num_codecs != 1)
+        return -ENODEV;
+
+    t->codec.dev = &t->dev;
+    t->codec.component.card = &test_card;
+    t->codec.dapm.codec = &t->codec;
+    t->dai.dev = &t->dev;
+    t->dai.codec = &t->codec;
+    t->substream.runtime = &t->runtime;
+    return host_codecs[0].driver->probe(&t->codec);
+}
+
+static void test_clear(struct test_codec *t) {
+    host_regmap_clear_stats(t->map);
+}
+
+//已上电时,缓存中的每个寄存器都应与芯片一致
+static void test_check_synced(struct test_codec *t, const char *when) {
+    unsigned int reg;
+
+    for (reg = 0; reg < ADAU19XX_NUM_REGS; reg++) {
+        if (t->map->present[reg])
+            CHECK(t->map->hw[reg] == t->map->cache[reg], "%s: %s reg 0x%02x hw 0x%02x cache 0x%02x",
+                    when, t->dev.name, reg, t->map->hw[reg], t->map->cache[reg]);
+    }
+    CHECK(t->map->warnings == 0, "%s: %u regmap warnings", when, t->map->warnings);
+}
+
+#define CHECK_HW(t, reg, val) CHECK((t)->map->hw[reg] == (val), "%s hw 0x%02x = 0x%02x, expected 0x%02x", \
+        (t)->dev.name, reg, (t)->map->hw[reg], (unsigned int)(val))
+#define CHECK_XFERS(t, reads, writes) CHECK((t)->map->xfers[HOST_XFER_READ] == (reads) && \
+        (t)->map->xfers[HOST_XFER_WRITE] == (writes), "%s xfers r%u w%u, expected r%u w%u", (t)->dev.name, \
+        (t)->map->xfers[HOST_XFER_READ], (t)->map->xfers[HOST_XFER_WRITE], reads, writes)
+
+static int test_set_fmt(struct test_codec *t, unsigned int fmt) {
+    return adau19xx_dai_ops.set_fmt(&t->dai, fmt);
+}
+
+static int test_hw_params(struct test_codec *t, unsigned int rate, unsigned int width) {
+    struct snd_pcm_hw_params params = { .rate = rate, .width = width };
+
+    return adau19xx_dai_ops.hw_params(&t->substream, &params, &t->dai);
+}
+
+//按DAPM的顺序给部件上下电,与内核一样持有声卡的dapm_mutex
+static int test_dapm_power(struct test_codec *t, const char *name, bool on) {
+    struct snd_soc_dapm_widget *w = NULL;
+    unsigned int i;
+    int ret;
+
+    for (i = 0; i < t->codec.dapm.num_widgets; i++) {
+        if (strcmp(t->codec.dapm.widgets[i].name, name) == 0)
+            w = &t->codec.dapm.widgets[i];
+    }
+    if (!w || w->reg == SND_SOC_NOPM)
+        return -EINVAL;
+
+    mutex_lock(&test_card.dapm_mutex);
+    if (!on && w->event && (w->event_flags & SND_SOC_DAPM_PRE_PMD))
+        w->event(w, NULL, SND_SOC_DAPM_PRE_PMD);
+    ret = regmap_update_bits(t->adau19xx->regmap, w->reg, BIT(w->shift), on ? BIT(w->shift) : 0);
+    if (on && w->event && (w->event_flags & SND_SOC_DAPM_POST_PMU))
+        w->event(w, NULL, SND_SOC_DAPM_POST_PMU);
+    mutex_unlock(&test_card.dapm_mutex);
+
+    return ret;
+}
+
+static int test_set_bias(struct test_codec *t, enum snd_soc_bias_level level) {
+    int ret;
+
+    mutex_lock(&test_card.dapm_mutex);
+    ret = host_codecs[0].driver->set_bias_level(&t->codec, level);
+    mutex_unlock(&test_card.dapm_mutex);
+    return ret;
+}
+
+static void test_probe_power_up(void) {
+    struct test_codec t;
+    unsigned int reg;
+    int ret;
+
+    ret = test_probe(&t, "probe", ADAU1977, test_props_lrclk);
+    CHECK(ret == 0, "probe %d", ret);
+    if (ret)
+        return;
+
+    CHECK(t.adau19xx->enabled, "not enabled");
+    CHECK(!t.map->cache_only, "left in cache-only mode");
+    //复位、PWUP、PLL为默认值时重写一次以启动PLL;缓存未改动,regcache_sync不产生传输
+    CHECK_XFERS(&t, 0, 3);
+    CHECK(t.map->hw_writes[ADAU19XX_REG_POWER] == 2, "POWER written %u times", t.map->hw_writes[ADAU19XX_REG_POWER]);
+    CHECK(t.map->hw_writes[ADAU19XX_REG_PLL] == 1, "PLL written %u times", t.map->hw_writes[ADAU19XX_REG_PLL]);
+    CHECK(t.map->delay_us == ADAU19XX_SOFT_RESET_DELAY_US + ADAU19XX_PWUP_DELAY_US, "delay %uus", t.map->delay_us);
+    for (reg = 0; reg < ADAU19XX_NUM_REGS; reg++) {
+        if (reg != ADAU19XX_REG_POWER)
+            CHECK_HW(&t, reg, test_hw_defaults[reg]);
+    }
+    CHECK_HW(&t, ADAU19XX_REG_POWER, ADAU19XX_POWER_PWUP);
+    test_check_synced(&t, "probe");
+
+    //ADAU1977:通用部件10个加Boost/MICBIAS;路径9条加MICBIAS 5条
+    CHECK(t.codec.dapm.num_widgets == 12, "%u widgets", t.codec.dapm.num_widgets);
+    CHECK(t.codec.dapm.num_routes == 14, "%u routes", t.codec.dapm.num_routes);
+    CHECK(t.adau19xx->codec == &t.codec, "codec not recorded");
+}
+
+static void test_probe_adau1978(void) {
+    struct test_codec t;
+    int ret;
+
+    ret = test_probe(&t, "probe-1978", ADAU1978, test_props_lrclk);
+    CHECK(ret == 0, "probe %d", ret);
+    if (ret)
+        return;
+
+    CHECK_XFERS(&t, 0, 3);
+    CHECK(t.map->hw_writes[ADAU19XX_REG_BOOST] == 0 && t.map->hw_writes[ADAU19XX_REG_MICBIAS] == 0,
+            "ADAU1978 boost/micbias written");
+    CHECK(t.codec.dapm.num_widgets == 10, "%u widgets", t.codec.dapm.num_widgets);
+    CHECK(t.codec.dapm.num_routes == 9, "%u routes", t.codec.dapm.num_routes);
+    test_check_synced(&t, "probe-1978");
+}
+
+static void test_probe_init_regs(void) {
+    static const u32 regs[] = {
+        ADAU19XX_REG_POST_ADC_GAIN(0), 0x90,
+        ADAU19XX_REG_POST_ADC_GAIN(1), 0x90,
+        ADAU19XX_REG_DC_HPF_CAL, 0x11,
+        ADAU19XX_REG_MISC_CONTROL, ADAU19XX_MISC_CONTROL_SUM_MODE_2,
+    };
+    static const struct host_property props[] = {
+        { "sysclk-src", test_src_lrclk, 1 },
+        { "adi,init-regs", regs, ARRAY_SIZE(regs) },
+        { NULL },
+    };
+    struct test_codec t;
+    int ret;
+
+    ret = test_probe(&t, "init-regs", ADAU1977, props);
+    CHECK(ret == 0, "probe %d", ret);
+    if (ret)
+        return;
+
+    CHECK_HW(&t, ADAU19XX_REG_POWER, ADAU19XX_POWER_PWUP);
+    CHECK_HW(&t, ADAU19XX_REG_POST_ADC_GAIN(0), 0x90);
+    CHECK_HW(&t, ADAU19XX_REG_POST_ADC_GAIN(1), 0x90);
+    CHECK_HW(&t, ADAU19XX_REG_DC_HPF_CAL, 0x11);
+    //SUM_MODE写入,驱动独占的MMUTE/DC_CAL保持默认
+    CHECK_HW(&t, ADAU19XX_REG_MISC_CONTROL, ADAU19XX_MISC_CONTROL_SUM_MODE_2);
+    //复位、PWUP、PLL重写,加上同步时改动过的寄存器按连续段各一次:0x0a~0x0b、0x0e、0x1a
+    CHECK_XFERS(&t, 0, 6);
+    test_check_synced(&t, "init-regs");
+}
+
+static void test_probe_init_regs_rejected(void) {
+    static const struct {
+        enum adau19xx_type type;
+        u32 regs[4];
+        const char *why;
+    } cases[] = {
+        { ADAU1977, { ADAU19XX_REG_POST_ADC_GAIN(0), 0x90, ADAU19XX_REG_ADC_CLIP, 0 }, "not writeable" },
+        { ADAU1977, { ADAU19XX_REG_POST_ADC_GAIN(0), 0x90, ADAU19XX_REG_ADC_BIAS_CONTROL, 0 }, "volatile" },
+        { ADAU1977, { ADAU19XX_REG_POST_ADC_GAIN(0), 0x90, ADAU19XX_REG_POWER, 0 }, "managed by the driver" },
+        { ADAU1977, { ADAU19XX_REG_POST_ADC_GAIN(0), 0x90, ADAU19XX_REG_BLOCK_POWER_SAI, 0x01 }, "bits managed" },
+        { ADAU1977, { ADAU19XX_REG_POST_ADC_GAIN(0), 0x90, ADAU19XX_REG_POST_ADC_GAIN(1), 0x100 }, "out of range" },
+        { ADAU1978, { ADAU19XX_REG_POST_ADC_GAIN(0), 0x90, ADAU19XX_REG_BOOST, 0x4a }, "not writeable" },
+    };
+    struct host_property props[] = {
+        { "sysclk-src", test_src_lrclk, 1 },
+        { "adi,init-regs", NULL, 4 },
+        { NULL },
+    };
+    struct test_codec t;
+    unsigned int i;
+    int ret;
+
+    for (i = 0; i < ARRAY_SIZE(cases); i++) {
+        props[1].vals = cases[i].regs;
+        host_last_msg[0] = 0;
+        ret = test_probe(&t, "init-regs-bad", cases[i].type, props);
+        CHECK(ret == -EINVAL, "case %u: probe %d", i, ret);
+        //出错的是第2项,错误信息指出是哪一项和原因
+        CHECK(strstr(host_last_msg, "entry 1") && strstr(host_last_msg, cases[i].why),
+                "case %u: message \"%s\"", i, host_last_msg);
+        CHECK_XFERS(&t, 0, 0);
+    }
+}
+
+static void test_set_fmt_regs(void) {
+    struct test_codec t;
+    int ret;
+
+    if (test_probe(&t, "set-fmt", ADAU1977, test_props_lrclk))
+        return;
+
+    //与默认值相同,不产生传输
+    test_clear(&t);
+    ret = test_set_fmt(&t, SND_SOC_DAIFMT_I2S | SND_SOC_DAIFMT_NB_NF | SND_SOC_DAIFMT_CBS_CFS);
+    CHECK(ret == 0, "I2S %d", ret);
+    CHECK_XFERS(&t, 0, 0);
+    CHECK(!t.adau19xx->master, "master");
+
+    test_clear(&t);
+    ret = test_set_fmt(&t, SND_SOC_DAIFMT_DSP_A | SND_SOC_DAIFMT_NB_NF | SND_SOC_DAIFMT_CBS_CFS);
+    CHECK(ret == 0, "DSP_A %d", ret);
+    CHECK_HW(&t, ADAU19XX_REG_SAI_CTRL1, ADAU19XX_SAI_CTRL1_LRCLK_PULSE);
+    CHECK_XFERS(&t, 0, 1);
+
+    //左对齐需要反转LRCLK,IF再反转一次;IB设置BCLK_EDGE
+    test_clear(&t);
+    ret = test_set_fmt(&t, SND_SOC_DAIFMT_LEFT_J | SND_SOC_DAIFMT_IB_IF | SND_SOC_DAIFMT_CBS_CFS);
+    CHECK(ret == 0, "LEFT_J %d", ret);
+    CHECK_HW(&t, ADAU19XX_REG_BLOCK_POWER_SAI, test_hw_defaults[ADAU19XX_REG_BLOCK_POWER_SAI] |
+            ADAU19XX_BLOCK_POWER_SAI_BCLK_EDGE);
+    CHECK_HW(&t, ADAU19XX_REG_SAI_CTRL0, ADAU19XX_SAI_CTRL0_FMT_LJ | ADAU19XX_SAI_CTRL0_FS_32000_48000);
+    CHECK_HW(&t, ADAU19XX_REG_SAI_CTRL1, 0);
+    CHECK_XFERS(&t, 0, 3);
+
+    test_clear(&t);
+    ret = test_set_fmt(&t, SND_SOC_DAIFMT_RIGHT_J | SND_SOC_DAIFMT_NB_NF | SND_SOC_DAIFMT_CBS_CFS);
+    CHECK(ret == 0, "RIGHT_J %d", ret);
+    CHECK(t.adau19xx->right_j, "right_j not set");
+    CHECK_HW(&t, ADAU19XX_REG_BLOCK_POWER_SAI, test_hw_defaults[ADAU19XX_REG_BLOCK_POWER_SAI] |
+            ADAU19XX_BLOCK_POWER_SAI_LR_POL);
+    CHECK_HW(&t, ADAU19XX_REG_SAI_CTRL0, ADAU19XX_SAI_CTRL0_FMT_RJ_24BIT | ADAU19XX_SAI_CTRL0_FS_32000_48000);
+    CHECK_XFERS(&t, 0, 2);
+
+    //sysclk-src为LRCLK时不能作为时钟主机,寄存器不变
+    test_clear(&t);
+    ret = test_set_fmt(&t, SND_SOC_DAIFMT_I2S | SND_SOC_DAIFMT_NB_NF | SND_SOC_DAIFMT_CBM_CFM);
+    CHECK(ret == -EINVAL, "master with LRCLK source %d", ret);
+    CHECK_XFERS(&t, 0, 0);
+
+    test_check_synced(&t, "set-fmt");
+}
+
+static void test_hw_params_slave(void) {
+    struct test_codec t;
+    int ret;
+
+    if (test_probe(&t, "hw-params", ADAU1977, test_props_lrclk))
+        return;
+    test_set_fmt(&t, SND_SOC_DAIFMT_I2S | SND_SOC_DAIFMT_NB_NF | SND_SOC_DAIFMT_CBS_CFS);
+
+    //PLL改为LRCLK输入,FS字段与默认值相同
+    test_clear(&t);
+    ret = test_hw_params(&t, 48000, 32);
+    CHECK(ret == 0, "48k %d", ret);
+    CHECK_HW(&t, ADAU19XX_REG_PLL, (test_hw_defaults[ADAU19XX_REG_PLL] & ~(ADAU19XX_PLL_MCS_MASK | ADAU19XX_PLL_CLK_S)) |
+            ADAU19XX_PLL_CLK_S);
+    CHECK_HW(&t, ADAU19XX_REG_SAI_CTRL0, ADAU19XX_SAI_CTRL0_FS_32000_48000);
+    CHECK_XFERS(&t, 0, 1);
+    CHECK(t.adau19xx->clk_src == ADAU19XX_SYSCLK_SRC_LRCLK, "clk_src %d", t.adau19xx->clk_src);
+
+    //重复相同参数不产生传输
+    test_clear(&t);
+    ret = test_hw_params(&t, 48000, 32);
+    CHECK(ret == 0, "48k again %d", ret);
+    CHECK_XFERS(&t, 0, 0);
+
+    test_clear(&t);
+    ret = test_hw_params(&t, 96000, 32);
+    CHECK(ret == 0, "96k %d", ret);
+    CHECK_HW(&t, ADAU19XX_REG_SAI_CTRL0, ADAU19XX_SAI_CTRL0_FS_64000_96000);
+    CHECK_XFERS(&t, 0, 1);
+
+    test_clear(&t);
+    ret = test_hw_params(&t, 50000, 32);
+    CHECK(ret == -EINVAL, "50k %d", ret);
+    CHECK_XFERS(&t, 0, 0);
+
+    test_check_synced(&t, "hw-params");
+}
+
+static void test_hw_params_master(void) {
+    struct test_codec t;
+    int ret;
+
+    if (test_probe(&t, "hw-params-master", ADAU1977, test_props_mclk))
+        return;
+
+    //MCLK 12.288MHz:可产生32k和48k两组采样率,PLL时钟源本来就是MCLK
+    test_clear(&t);
+    ret = adau19xx_dai_ops.set_sysclk(&t.dai, ADAU19XX_SYSCLK, 12288000, SND_SOC_CLOCK_IN);
+    CHECK(ret == 0, "set_sysclk %d", ret);
+    CHECK(t.adau19xx->constraints.mask == (ADAU19XX_RATE_CONSTRAINT_MASK_32000 | ADAU19XX_RATE_CONSTRAINT_MASK_48000),
+            "rate mask 0x%x", t.adau19xx->constraints.mask);
+    CHECK_XFERS(&t, 0, 0);
+
+    test_clear(&t);
+    ret = test_set_fmt(&t, SND_SOC_DAIFMT_I2S | SND_SOC_DAIFMT_NB_NF | SND_SOC_DAIFMT_CBM_CFM);
+    CHECK(ret == 0, "master %d", ret);
+    CHECK_HW(&t, ADAU19XX_REG_SAI_CTRL1, ADAU19XX_SAI_CTRL1_MASTER);
+    CHECK_XFERS(&t, 0, 1);
+
+    //48k 24位:256fs对应MCS=1,与PLL默认值相同;每个slot 32个BCLK
+    test_clear(&t);
+    ret = test_hw_params(&t, 48000, 24);
+    CHECK(ret == 0, "48k %d", ret);
+    CHECK_HW(&t, ADAU19XX_REG_PLL, 0x41);
+    CHECK_HW(&t, ADAU19XX_REG_SAI_CTRL1, ADAU19XX_SAI_CTRL1_MASTER);
+    CHECK_XFERS(&t, 0, 0);
+    CHECK(test_bclk == 48000 * 64 && test_lrclk == 48000, "clocks %lu/%lu", test_bclk, test_lrclk);
+
+    //16k 16位:768fs对应MCS=2,FS、位宽和每个slot的BCLK数都改变
+    test_clear(&t);
+    ret = test_hw_params(&t, 16000, 16);
+    CHECK(ret == 0, "16k %d", ret);
+    CHECK_HW(&t, ADAU19XX_REG_PLL, 0x42);
+    CHECK_HW(&t, ADAU19XX_REG_SAI_CTRL0, ADAU19XX_SAI_CTRL0_FS_16000_24000);
+    CHECK_HW(&t, ADAU19XX_REG_SAI_CTRL1, ADAU19XX_SAI_CTRL1_MASTER | ADAU19XX_SAI_CTRL1_DATA_WIDTH_16BIT |
+            ADAU19XX_SAI_CTRL1_BCLKRATE_16);
+    CHECK_XFERS(&t, 0, 3);
+    CHECK(test_bclk == 16000 * 32 && test_lrclk == 16000, "clocks %lu/%lu", test_bclk, test_lrclk);
+
+    //44.1k不能由12.288MHz产生
+    test_clear(&t);
+    ret = test_hw_params(&t, 44100, 24);
+    CHECK(ret == -EINVAL, "44.1k %d", ret);
+    CHECK_XFERS(&t, 0, 0);
+
+    test_check_synced(&t, "hw-params-master");
+}
+
+static void test_power_cycle(void) {
+    struct test_codec t;
+    int ret;
+
+    if (test_probe(&t, "power", ADAU1977, test_props_lrclk))
+        return;
+    test_set_fmt(&t, SND_SOC_DAIFMT_I2S | SND_SOC_DAIFMT_NB_NF | SND_SOC_DAIFMT_CBS_CFS);
+    test_hw_params(&t, 48000, 32);
+    regmap_write(t.map, ADAU19XX_REG_POST_ADC_GAIN(0), 0x80);
+
+    //掉电:只清PWUP,之后只写缓存
+    test_clear(&t);
+    ret = adau19xx_pm_ops.suspend(&t.dev);
+    CHECK(ret == 0, "suspend %d", ret);
+    CHECK(!t.adau19xx->enabled && t.map->cache_only, "not in cache-only mode");
+    CHECK_HW(&t, ADAU19XX_REG_POWER, 0);
+    CHECK_XFERS(&t, 0, 1);
+
+    test_clear(&t);
+    ret = adau19xx_pm_ops.suspend(&t.dev);
+    CHECK(ret == 0, "suspend again %d", ret);
+    regmap_update_bits(t.map, ADAU19XX_REG_POST_ADC_GAIN(1), 0xff, 0x70);
+    CHECK_XFERS(&t, 0, 0);
+
+    //芯片掉电丢失全部寄存器
+    test_chip_reset(t.map);
+
+    //上电:复位、PWUP,再按连续段同步与默认值不同的寄存器:PLL、0x0a~0x0b;PLL已非默认值,不再重写
+    test_clear(&t);
+    ret = adau19xx_pm_ops.resume(&t.dev);
+    CHECK(ret == 0, "resume %d", ret);
+    CHECK(t.adau19xx->enabled && !t.map->cache_only, "not powered");
+    CHECK_HW(&t, ADAU19XX_REG_POWER, ADAU19XX_POWER_PWUP);
+    CHECK_HW(&t, ADAU19XX_REG_PLL, 0x50);
+    CHECK_HW(&t, ADAU19XX_REG_POST_ADC_GAIN(0), 0x80);
+    CHECK_HW(&t, ADAU19XX_REG_POST_ADC_GAIN(1), 0x70);
+    CHECK_XFERS(&t, 0, 4);
+    test_check_synced(&t, "resume");
+
+    test_clear(&t);
+    ret = adau19xx_pm_ops.resume(&t.dev);
+    CHECK(ret == 0, "resume again %d", ret);
+    CHECK_XFERS(&t, 0, 0);
+}
+
+static int test_dc_cal_put(struct test_codec *t, long val) {
+    struct snd_kcontrol kcontrol = { .private_data = &t->codec };
+    struct snd_ctl_elem_value ucontrol;
+
+    memset(&ucontrol, 0, sizeof (ucontrol));
+    ucontrol.value.integer.value[0] = val;
+    return adau19xx_dc_cal_put(&kcontrol, &ucontrol);
+}
+
+static void test_dc_calibration(void) {
+    unsigned int misc = test_hw_defaults[ADAU19XX_REG_MISC_CONTROL];
+    struct test_codec t;
+    int ret;
+
+    if (test_probe(&t, "dc-cal", ADAU1977, test_props_lrclk))
+        return;
+
+    //置位只写硬件,轮询一次即完成;缓存中没有DC_CAL位,也没有打开全局cache_bypass
+    test_clear(&t);
+    test_calibrations = 0;
+    ret = test_dc_cal_put(&t, 1);
+    CHECK(ret == 1, "calibrate %d", ret);
+    CHECK(test_calibrations == 1, "%u calibrations", test_calibrations);
+    CHECK(t.adau19xx->dc_cal_done, "not done");
+    CHECK_HW(&t, ADAU19XX_REG_MISC_CONTROL, misc);
+    CHECK(t.map->cache[ADAU19XX_REG_MISC_CONTROL] == misc, "cache MISC 0x%02x", t.map->cache[ADAU19XX_REG_MISC_CONTROL]);
+    CHECK(!t.map->cache_bypass, "cache bypass left on");
+    CHECK_XFERS(&t, 1, 1);
+
+    //复位丢失校准结果,下次BIAS_ON时补做
+    adau19xx_pm_ops.suspend(&t.dev);
+    adau19xx_pm_ops.resume(&t.dev);
+    CHECK(t.adau19xx->dc_cal_pending, "recalibration not pending");
+    test_clear(&t);
+    ret = test_set_bias(&t, SND_SOC_BIAS_ON);
+    CHECK(ret == 0, "bias on %d", ret);
+    CHECK(test_calibrations == 2 && !t.adau19xx->dc_cal_pending, "%u calibrations", test_calibrations);
+    CHECK_XFERS(&t, 1, 1);
+
+    test_clear(&t);
+    ret = test_set_bias(&t, SND_SOC_BIAS_ON);
+    CHECK_XFERS(&t, 0, 0);
+
+    //超时:每个轮询间隔读一次,最后按缓存清除DC_CAL
+    test_dc_cal_stuck = true;
+    test_clear(&t);
+    ret = test_dc_cal_put(&t, 1);
+    test_dc_cal_stuck = false;
+    CHECK(ret == -ETIMEDOUT, "stuck calibration %d", ret);
+    CHECK(!t.adau19xx->dc_cal_done, "done after timeout");
+    CHECK_HW(&t, ADAU19XX_REG_MISC_CONTROL, misc);
+    CHECK_XFERS(&t, ADAU19XX_DC_CAL_TIMEOUT_US / ADAU19XX_DC_CAL_POLL_US + 1, 2);
+
+    //掉电时不能校准
+    adau19xx_pm_ops.suspend(&t.dev);
+    test_clear(&t);
+    ret = test_dc_cal_put(&t, 1);
+    CHECK(ret == -EBUSY, "calibrate while off %d", ret);
+    CHECK_XFERS(&t, 0, 0);
+}
+
+static int test_mute(struct test_codec *t, int mute) {
+    return adau19xx_dai_ops.mute_stream(&t->dai, mute, 1);
+}
+
+//打开录音流:startup、hw_params、ADC上电、静音
+static void test_stream_open(struct test_codec *t) {
+    adau19xx_dai_ops.startup(&t->substream, &t->dai);
+    test_hw_params(t, 48000, 32);
+    test_dapm_power(t, "Vref", true);
+    test_dapm_power(t, "ADC1", true);
+    test_dapm_power(t, "ADC2", true);
+    test_mute(t, 1);
+}
+
+static void test_sync_group(void) {
+    static const u32 group_id[] = { 1 };
+    static const struct host_property props[] = {
+        { "sysclk-src", test_src_lrclk, 1 },
+        { "adi,sync-group", group_id, 1 },
+        { NULL },
+    };
+    static struct test_codec a, b;
+    unsigned int block = test_hw_defaults[ADAU19XX_REG_BLOCK_POWER_SAI] | 0x03;
+    unsigned int misc = test_hw_defaults[ADAU19XX_REG_MISC_CONTROL];
+    int ret;
+
+    if (test_probe(&a, "group-a", ADAU1977, props) || test_probe(&b, "group-b", ADAU1977, props)) {
+        CHECK(0, "probe failed");
+        return;
+    }
+    CHECK(a.adau19xx->group && a.adau19xx->group == b.adau19xx->group, "not in one group");
+
+    test_stream_open(&a);
+    test_stream_open(&b);
+    CHECK_HW(&a, ADAU19XX_REG_BLOCK_POWER_SAI, block);
+    CHECK_HW(&a, ADAU19XX_REG_MISC_CONTROL, misc | ADAU19XX_MISC_CONTROL_MMUTE);
+
+    //第一个成员就绪:等待另一个,不访问总线
+    test_clear(&a);
+    test_clear(&b);
+    ret = test_mute(&a, 0);
+    CHECK(ret == 0, "unmute a %d", ret);
+    CHECK_XFERS(&a, 0, 0);
+    CHECK(delayed_work_pending(&a.adau19xx->group->release_work), "timeout not armed");
+    CHECK_HW(&a, ADAU19XX_REG_MISC_CONTROL, misc | ADAU19XX_MISC_CONTROL_MMUTE);
+
+    //最后一个成员就绪:两片先各关ADC,再各自恢复ADC并解除静音
+    ret = test_mute(&b, 0);
+    CHECK(ret == 0, "unmute b %d", ret);
+    CHECK_XFERS(&a, 0, 3);
+    CHECK_XFERS(&b, 0, 3);
+    CHECK(a.map->hw_writes[ADAU19XX_REG_BLOCK_POWER_SAI] == 2, "a BLOCK_POWER written %u times",
+            a.map->hw_writes[ADAU19XX_REG_BLOCK_POWER_SAI]);
+    CHECK_HW(&a, ADAU19XX_REG_BLOCK_POWER_SAI, block);
+    CHECK_HW(&b, ADAU19XX_REG_BLOCK_POWER_SAI, block);
+    CHECK_HW(&a, ADAU19XX_REG_MISC_CONTROL, misc);
+    CHECK_HW(&b, ADAU19XX_REG_MISC_CONTROL, misc);
+    CHECK(a.adau19xx->group_running && b.adau19xx->group_running, "not running");
+    CHECK(!delayed_work_pending(&a.adau19xx->group->release_work), "timeout still armed");
+    //同一声卡的dapm_mutex只锁一次,结束后全部释放
+    CHECK(!test_card.dapm_mutex.locked && !a.adau19xx->lock.locked && !b.adau19xx->lock.locked, "lock held");
+    test_check_synced(&a, "group");
+    test_check_synced(&b, "group");
+
+    //b关闭音频流后再打开,a已在运行,b超时后单独解除静音
+    adau19xx_dai_ops.shutdown(&b.substream, &b.dai);
+    test_stream_open(&b);
+    adau19xx_dai_ops.startup(&a.substream, &a.dai);
+    test_mute(&a, 1);
+    test_clear(&a);
+    test_clear(&b);
+    test_mute(&b, 0);
+    CHECK_XFERS(&b, 0, 0);
+    CHECK(host_run_delayed_work(&b.adau19xx->group->release_work), "timeout not armed");
+    CHECK_XFERS(&a, 0, 0);
+    CHECK_XFERS(&b, 0, 3);
+    CHECK_HW(&b, ADAU19XX_REG_MISC_CONTROL, misc);
+    CHECK_HW(&a, ADAU19XX_REG_MISC_CONTROL, misc | ADAU19XX_MISC_CONTROL_MMUTE);
+    test_check_synced(&b, "group timeout");
+
+    host_device_unbind(&a.dev);
+    host_device_unbind(&b.dev);
+    CHECK(list_empty(&adau19xx_groups), "group not freed");
+}
+
+int main(void) {
+    test_probe_power_up();
+    test_probe_adau1978();
+    test_probe_init_regs();
+    test_probe_init_regs_rejected();
+    test_set_fmt_regs();
+    test_hw_params_slave();
+    test_hw_params_master();
+    test_power_cycle();
+    test_dc_calibration();
+    test_sync_group();
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
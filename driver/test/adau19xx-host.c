@@ -0,0 +1,427 @@
+//adau19xx-host.h中内核接口的主机实现,供adau19xx-codec-test使用
+//regmap按内核4.14的regmap/regcache行为实现,总线按raw格式(可连续写)计传输次数:
+//  读写先经缓存,cache_only时写只进缓存并标记dirty,读缓存中没有的寄存器返回-EBUSY
+//  regmap_update_bits值不变时不写;regmap_multi_reg_write_bypassed逐个写硬件,不碰缓存
+//  regcache_sync只在dirty时执行,把缓存中可写寄存器按连续段各写一次;
+//  mark_dirty之后的一次同步跳过与默认值相同的寄存器(no_sync_defaults)
+//  缓存按一个rbtree块处理:ADAU19xx的默认值之间只隔几个易失寄存器,内核中也合并在同一块
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "adau19xx-host.h"
+
+char host_last_msg[256];
+
+void host_printk(int level, const struct device *dev, const char *fmt, ...) {
+    va_list args;
+
+    //只保留警告和错误,调试信息丢弃
+    if (level > 1)
+        return;
+    va_start(args, fmt);
+    vsnprintf(host_last_msg, sizeof (host_last_msg), fmt, args);
+    va_end(args);
+    if (getenv("ADAU19XX_TEST_VERBOSE"))
+        printf("  [%s] %s", dev ? dev->name : "-", host_last_msg);
+}
+
+static void host_bug(const char *what, const void *ptr) {
+    printf("BUG: %s %p\n", what, ptr);
+    abort();
+}
+
+void mutex_init(struct mutex *lock) {
+    lock->locked = 0;
+}
+
+void mutex_lock(struct mutex *lock) {
+    //单线程下重复加锁即为死锁
+    if (lock->locked)
+        host_bug("recursive mutex_lock", lock);
+    lock->locked = 1;
+}
+
+void mutex_unlock(struct mutex *lock) {
+    if (!lock->locked)
+        host_bug("mutex_unlock of unlocked mutex", lock);
+    lock->locked = 0;
+}
+
+ktime_t ktime_get(void) {
+    static ktime_t now;
+
+    now += 1000;
+    return now;
+}
+
+bool host_run_delayed_work(struct delayed_work *dwork) {
+    if (!dwork->pending)
+        return false;
+    dwork->pending = false;
+    dwork->work.func(&dwork->work);
+    return true;
+}
+
+void *kzalloc(size_t size, gfp_t flags) {
+    return calloc(1, size);
+}
+
+void *kcalloc(size_t n, size_t size, gfp_t flags) {
+    return calloc(n, size);
+}
+
+void kfree(const void *ptr) {
+    free((void *)ptr);
+}
+
+void *devm_kzalloc(struct device *dev, size_t size, gfp_t flags) {
+    return calloc(1, size);
+}
+
+void *devm_kcalloc(struct device *dev, size_t n, size_t size, gfp_t flags) {
+    return calloc(n, size);
+}
+
+int devm_add_action_or_reset(struct device *dev, void (*action)(void *data), void *data) {
+    if (dev->num_actions == HOST_DEV_ACTIONS) {
+        action(data);
+        return -ENOMEM;
+    }
+    dev->actions[dev->num_actions] = action;
+    dev->action_data[dev->num_actions] = data;
+    dev->num_actions++;
+    return 0;
+}
+
+void host_device_unbind(struct device *dev) {
+    while (dev->num_actions) {
+        dev->num_actions--;
+        dev->actions[dev->num_actions](dev->action_data[dev->num_actions]);
+    }
+}
+
+static const struct host_property *host_find_property(const struct device_node *np, const char *propname) {
+    const struct host_property *prop;
+
+    if (!np || !np->props)
+        return NULL;
+    for (prop = np->props; prop->name; prop++) {
+        if (strcmp(prop->name, propname) == 0)
+            return prop;
+    }
+    return NULL;
+}
+
+int of_property_read_u32(const struct device_node *np, const char *propname, u32 *out) {
+    const struct host_property *prop = host_find_property(np, propname);
+
+    if (!prop)
+        return -EINVAL;
+    if (!prop->vals || prop->num < 1)
+        return -EOVERFLOW;
+    *out = prop->vals[0];
+    return 0;
+}
+
+bool of_property_read_bool(const struct device_node *np, const char *propname) {
+    return host_find_property(np, propname) != NULL;
+}
+
+int of_property_count_u32_elems(const struct device_node *np, const char *propname) {
+    const struct host_property *prop = host_find_property(np, propname);
+
+    if (!prop)
+        return -EINVAL;
+    return prop->num;
+}
+
+int of_property_read_u32_array(const struct device_node *np, const char *propname, u32 *out, size_t sz) {
+    const struct host_property *prop = host_find_property(np, propname);
+
+    if (!prop)
+        return -EINVAL;
+    if (prop->num < (int)sz)
+        return -EOVERFLOW;
+    memcpy(out, prop->vals, sz * sizeof (*out));
+    return 0;
+}
+
+int device_property_read_u32(struct device *dev, const char *propname, u32 *val) {
+    return of_property_read_u32(dev->of_node, propname, val);
+}
+
+//regmap
+static bool host_regmap_writeable(struct regmap *map, unsigned int reg) {
+    if (reg > map->config->max_register)
+        return false;
+    return !map->config->writeable_reg || map->config->writeable_reg(map->dev, reg);
+}
+
+static bool host_regmap_readable(struct regmap *map, unsigned int reg) {
+    if (reg > map->config->max_register)
+        return false;
+    return !map->config->readable_reg || map->config->readable_reg(map->dev, reg);
+}
+
+static bool host_regmap_volatile(struct regmap *map, unsigned int reg) {
+    if (!host_regmap_readable(map, reg))
+        return false;
+    if (map->config->volatile_reg)
+        return map->config->volatile_reg(map->dev, reg);
+    return map->config->cache_type == REGCACHE_NONE;
+}
+
+static bool host_regmap_default(struct regmap *map, unsigned int reg, unsigned int *def) {
+    unsigned int i;
+
+    for (i = 0; i < map->config->num_reg_defaults; i++) {
+        if (map->config->reg_defaults[i].reg == reg) {
+            *def = map->config->reg_defaults[i].def;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct regmap *host_regmap_init(struct device *dev, const struct regmap_config *config) {
+    struct regmap *map = calloc(1, sizeof (*map));
+    unsigned int i;
+
+    if (!map)
+        return NULL;
+    map->dev = dev;
+    map->config = config;
+    for (i = 0; i < config->num_reg_defaults; i++) {
+        map->cache[config->reg_defaults[i].reg] = config->reg_defaults[i].def;
+        map->present[config->reg_defaults[i].reg] = true;
+    }
+    return map;
+}
+
+void host_regmap_clear_stats(struct regmap *map) {
+    memset(map->xfers, 0, sizeof (map->xfers));
+    memset(map->hw_writes, 0, sizeof (map->hw_writes));
+    map->delay_us = 0;
+}
+
+//一次总线写:从reg开始连续count个寄存器
+static int host_regmap_hw_write(struct regmap *map, unsigned int reg, const unsigned int *vals, size_t count) {
+    size_t i;
+
+    map->xfers[HOST_XFER_WRITE]++;
+    for (i = 0; i < count; i++) {
+        map->hw_writes[reg + i]++;
+        if (map->hw_write)
+            map->hw_write(map, reg + i, vals[i]);
+        else
+            map->hw[reg + i] = vals[i];
+    }
+    return 0;
+}
+
+int host_regmap_hw_read(struct regmap *map, unsigned int reg, u8 *buf, size_t count) {
+    if (reg + count > HOST_REGMAP_REGS)
+        return -EINVAL;
+    map->xfers[HOST_XFER_READ]++;
+    memcpy(buf, map->hw + reg, count);
+    return 0;
+}
+
+static void host_regcache_write(struct regmap *map, unsigned int reg, unsigned int val) {
+    if (map->config->cache_type == REGCACHE_NONE || host_regmap_volatile(map, reg))
+        return;
+    map->cache[reg] = val;
+    map->present[reg] = true;
+}
+
+static int host_regmap_do_read(struct regmap *map, unsigned int reg, unsigned int *val) {
+    u8 byte;
+    int ret;
+
+    if (!map->cache_bypass && map->config->cache_type != REGCACHE_NONE &&
+            !host_regmap_volatile(map, reg) && map->present[reg]) {
+        *val = map->cache[reg];
+        return 0;
+    }
+    if (map->cache_only)
+        return -EBUSY;
+    if (!host_regmap_readable(map, reg))
+        return -EIO;
+
+    ret = host_regmap_hw_read(map, reg, &byte, 1);
+    if (ret)
+        return ret;
+    *val = byte;
+    if (!map->cache_bypass)
+        host_regcache_write(map, reg, *val);
+    return 0;
+}
+
+static int host_regmap_do_write(struct regmap *map, unsigned int reg, unsigned int val) {
+    if (!host_regmap_writeable(map, reg))
+        return -EIO;
+
+    if (!map->cache_bypass) {
+        host_regcache_write(map, reg, val);
+        if (map->cache_only) {
+            map->cache_dirty = true;
+            return 0;
+        }
+    }
+    return host_regmap_hw_write(map, reg, &val, 1);
+}
+
+int regmap_read(struct regmap *map, unsigned int reg, unsigned int *val) {
+    return host_regmap_do_read(map, reg, val);
+}
+
+int regmap_write(struct regmap *map, unsigned int reg, unsigned int val) {
+    return host_regmap_do_write(map, reg, val);
+}
+
+int regmap_update_bits(struct regmap *map, unsigned int reg, unsigned int mask, unsigned int val) {
+    unsigned int orig, tmp;
+    int ret;
+
+    ret = host_regmap_do_read(map, reg, &orig);
+    if (ret)
+        return ret;
+    tmp = (orig & ~mask) | (val & mask);
+    if (tmp == orig)
+        return 0;
+    return host_regmap_do_write(map, reg, tmp);
+}
+
+int regmap_multi_reg_write_bypassed(struct regmap *map, const struct reg_sequence *regs, int num_regs) {
+    bool bypass = map->cache_bypass;
+    int i, ret = 0;
+
+    map->cache_bypass = true;
+    for (i = 0; i < num_regs; i++) {
+        ret = host_regmap_do_write(map, regs[i].reg, regs[i].def);
+        if (ret)
+            break;
+        map->delay_us += regs[i].delay_us;
+    }
+    map->cache_bypass = bypass;
+    return ret;
+}
+
+void regcache_cache_only(struct regmap *map, bool enable) {
+    if (map->cache_bypass && enable)
+        map->warnings++;
+    map->cache_only = enable;
+}
+
+void regcache_cache_bypass(struct regmap *map, bool enable) {
+    if (map->cache_only && enable)
+        map->warnings++;
+    map->cache_bypass = enable;
+}
+
+void regcache_mark_dirty(struct regmap *map) {
+    map->cache_dirty = true;
+    map->no_sync_defaults = true;
+}
+
+static bool host_regcache_needs_sync(struct regmap *map, unsigned int reg, unsigned int val) {
+    unsigned int def;
+
+    if (!map->no_sync_defaults)
+        return true;
+    return !host_regmap_default(map, reg, &def) || def != val;
+}
+
+//regcache_sync_block_raw:需要同步的连续寄存器合并为一次写
+static int host_regcache_sync_block(struct regmap *map, unsigned int min, unsigned int max) {
+    unsigned int run[HOST_REGMAP_REGS];
+    unsigned int base = 0, count = 0, reg;
+    int ret;
+
+    for (reg = min; reg <= max + 1; reg++) {
+        if (reg <= max && map->present[reg] && host_regmap_writeable(map, reg) &&
+                host_regcache_needs_sync(map, reg, map->cache[reg])) {
+            if (!count)
+                base = reg;
+            run[count++] = map->cache[reg];
+            continue;
+        }
+        if (count) {
+            ret = host_regmap_hw_write(map, base, run, count);
+            if (ret)
+                return ret;
+            count = 0;
+        }
+    }
+    return 0;
+}
+
+int regcache_sync(struct regmap *map) {
+    bool bypass = map->cache_bypass;
+    int ret = 0;
+
+    if (map->cache_dirty) {
+        map->cache_bypass = true;
+        ret = host_regcache_sync_block(map, 0, map->config->max_register);
+        if (ret == 0)
+            map->cache_dirty = false;
+    }
+    map->cache_bypass = bypass;
+    map->no_sync_defaults = false;
+    return ret;
+}
+
+int regcache_sync_region(struct regmap *map, unsigned int min, unsigned int max) {
+    bool bypass = map->cache_bypass;
+    int ret;
+
+    map->cache_bypass = true;
+    ret = host_regcache_sync_block(map, min, max);
+    map->cache_bypass = bypass;
+    map->no_sync_defaults = false;
+    return ret;
+}
+
+//ASoC登记
+struct host_codec_reg host_codecs[4];
+unsigned int host_num_codecs;
+
+int snd_soc_register_codec(struct device *dev, const struct snd_soc_codec_driver *codec_drv,
+        struct snd_soc_dai_driver *dai_drv, int num_dai) {
+    if (host_num_codecs == ARRAY_SIZE(host_codecs))
+        return -ENOMEM;
+    host_codecs[host_num_codecs].dev = dev;
+    host_codecs[host_num_codecs].driver = codec_drv;
+    host_codecs[host_num_codecs].dai = dai_drv;
+    host_num_codecs++;
+    return 0;
+}
+
+int snd_soc_add_codec_controls(struct snd_soc_codec *codec, const struct snd_kcontrol_new *controls,
+        unsigned int num_controls) {
+    codec->num_controls += num_controls;
+    return 0;
+}
+
+int snd_soc_dapm_new_controls(struct snd_soc_dapm_context *dapm,
+        const struct snd_soc_dapm_widget *widget, int num) {
+    int i;
+
+    for (i = 0; i < num; i++) {
+        if (dapm->num_widgets == HOST_DAPM_WIDGETS)
+            return -ENOMEM;
+        dapm->widgets[dapm->num_widgets] = widget[i];
+        dapm->widgets[dapm->num_widgets].dapm = dapm;
+        dapm->num_widgets++;
+    }
+    return 0;
+}
+
+int snd_soc_dapm_add_routes(struct snd_soc_dapm_context *dapm,
+        const struct snd_soc_dapm_route *route, int num) {
+    dapm->num_routes += num;
+    return 0;
+}
@@ -0,0 +1,188 @@
+//adau19xx驱动的主机单元测试:采样率/MCLK计算、寄存器描述表(每个地址恰好一行)和驱动独占位
+//只用到adau19xx.h,内核类型由test/include中的最小定义提供,不需要内核源码和芯片
+//  make -C driver/test
+
+#include <stdio.h>
+#include <string.h>
+
+#include "adau19xx.h"
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+    } \
+} while (0)
+
+//三个基准频率各自的采样率,都属于ADAU19XX_RATE_CONSTRAINT_MASK_*的一组
+static const unsigned int test_bases[] = { 32000, 44100, 48000 };
+static const unsigned int test_rates[][5] = {
+    { 8000, 16000, 32000, 64000, 128000 },
+    { 11025, 22050, 44100, 88200, 176400 },
+    { 12000, 24000, 48000, 96000, 192000 },
+};
+
+static void test_lookup_fs(void) {
+    static const struct {
+        unsigned int rate;
+        int fs;
+    } cases[] = {
+        { 8000, ADAU19XX_SAI_CTRL0_FS_8000_12000 },
+        { 12000, ADAU19XX_SAI_CTRL0_FS_8000_12000 },
+        { 16000, ADAU19XX_SAI_CTRL0_FS_16000_24000 },
+        { 22050, ADAU19XX_SAI_CTRL0_FS_16000_24000 },
+        { 32000, ADAU19XX_SAI_CTRL0_FS_32000_48000 },
+        { 44100, ADAU19XX_SAI_CTRL0_FS_32000_48000 },
+        { 48000, ADAU19XX_SAI_CTRL0_FS_32000_48000 },
+        { 88200, ADAU19XX_SAI_CTRL0_FS_64000_96000 },
+        { 96000, ADAU19XX_SAI_CTRL0_FS_64000_96000 },
+        { 128000, ADAU19XX_SAI_CTRL0_FS_128000_192000 },
+        { 192000, ADAU19XX_SAI_CTRL0_FS_128000_192000 },
+        { 7999, -EINVAL },
+        { 13000, -EINVAL },
+        { 25000, -EINVAL },
+        { 50000, -EINVAL },
+        { 100000, -EINVAL },
+        { 192001, -EINVAL },
+    };
+    unsigned int i;
+
+    for (i = 0; i < sizeof (cases) / sizeof (cases[0]); i++)
+        CHECK(adau19xx_lookup_fs(cases[i].rate) == cases[i].fs, "rate %u: fs %d, expected %d",
+                cases[i].rate, adau19xx_lookup_fs(cases[i].rate), cases[i].fs);
+}
+
+static void test_calc_mcs(void) {
+    static const struct {
+        unsigned int sysclk;
+        unsigned int rate;
+        int mcs;
+    } cases[] = {
+        { 6144000, 48000, 0 }, //128x
+        { 12288000, 48000, 1 }, //256x
+        { 18432000, 48000, 2 }, //384x
+        { 24576000, 48000, 3 }, //512x
+        { 36864000, 48000, 4 }, //768x
+        { 30720000, 48000, -EINVAL }, //640x不支持
+        { 49152000, 48000, -EINVAL }, //1024x超出范围
+        { 12288000, 44100, -EINVAL },
+        { 11289600, 44100, 1 },
+        { 12288000, 8000, 2 }, //低采样率按512/2^fs折算
+        { 12288000, 192000, 1 },
+        { 8192000, 32000, 1 },
+    };
+    unsigned int i;
+    int fs;
+
+    for (i = 0; i < sizeof (cases) / sizeof (cases[0]); i++) {
+        fs = adau19xx_lookup_fs(cases[i].rate);
+        CHECK(fs >= 0, "rate %u has no fs", cases[i].rate);
+        CHECK(adau19xx_calc_mcs(cases[i].sysclk, cases[i].rate, fs) == cases[i].mcs,
+                "sysclk %u rate %u: mcs %d, expected %d", cases[i].sysclk, cases[i].rate,
+                adau19xx_calc_mcs(cases[i].sysclk, cases[i].rate, fs), cases[i].mcs);
+    }
+}
+
+//set_sysclk按adau19xx_check_sysclk生成可用采样率,hw_params再用adau19xx_calc_mcs计算,两者必须一致
+static void test_sysclk_matches_mcs(void) {
+    unsigned int b, r, mult;
+    unsigned int mclk;
+    bool ok;
+    int mcs;
+
+    for (b = 0; b < sizeof (test_bases) / sizeof (test_bases[0]); b++) {
+        for (mult = 1; mult <= 16; mult++) {
+            mclk = test_bases[b] * 64 * mult;
+            ok = adau19xx_check_sysclk(mclk, test_bases[b]);
+            for (r = 0; r < 5; r++) {
+                mcs = adau19xx_calc_mcs(mclk, test_rates[b][r], adau19xx_lookup_fs(test_rates[b][r]));
+                CHECK(ok == (mcs >= 0), "mclk %u rate %u: check_sysclk %d, mcs %d",
+                        mclk, test_rates[b][r], ok, mcs);
+            }
+        }
+    }
+}
+
+#define TEST_REG_FLAGS(reg, name, def, kind) [reg] = ADAU19XX_REG_F_##kind,
+#define TEST_REG_DEF(reg, name, def, kind) [reg] = def,
+
+static const u8 test_reg_flags[ADAU19XX_NUM_REGS] = {
+    ADAU19XX_REG_TABLE(TEST_REG_FLAGS)
+};
+
+static const unsigned int test_reg_defs[ADAU19XX_NUM_REGS] = {
+    ADAU19XX_REG_TABLE(TEST_REG_DEF)
+};
+
+#define TEST_REG_ADDR(reg, name, def, kind) reg,
+#define TEST_REG_BIT(reg, name, def, kind) + (1ULL << (reg))
+
+//flags/defaults/names都用[reg] =指定下标生成,重复的地址会静默覆盖前一行,这里逐个地址计数
+static void test_reg_table_once(void) {
+    static const unsigned int addrs[] = { ADAU19XX_REG_TABLE(TEST_REG_ADDR) };
+    unsigned int seen[ADAU19XX_NUM_REGS] = { 0 };
+    unsigned int i;
+
+    for (i = 0; i < sizeof (addrs) / sizeof (addrs[0]); i++) {
+        CHECK(addrs[i] < ADAU19XX_NUM_REGS, "reg 0x%02x out of range", addrs[i]);
+        if (addrs[i] < ADAU19XX_NUM_REGS)
+            seen[addrs[i]]++;
+    }
+    for (i = 0; i < ADAU19XX_NUM_REGS; i++)
+        CHECK(seen[i] == 1, "reg 0x%02x appears %u times", i, seen[i]);
+
+    //与adau19xx_reg_table_check中的编译期检查相同的条件
+    CHECK((0 ADAU19XX_REG_TABLE(TEST_REG_BIT)) == (1ULL << ADAU19XX_NUM_REGS) - 1, "address bit sum mismatch");
+}
+
+static void test_reg_table(void) {
+    unsigned int reg;
+
+    for (reg = 0; reg < ADAU19XX_NUM_REGS; reg++) {
+        CHECK(test_reg_flags[reg] & ADAU19XX_REG_F_R, "reg 0x%02x not readable", reg);
+        CHECK(test_reg_defs[reg] <= 0xff, "reg 0x%02x default 0x%x", reg, test_reg_defs[reg]);
+    }
+
+    //状态寄存器不缓存,且不能出现在寄存器列表里
+    CHECK(test_reg_flags[ADAU19XX_REG_ADC_CLIP] & ADAU19XX_REG_F_VOLATILE, "ADC_CLIP not volatile");
+    CHECK(!(test_reg_flags[ADAU19XX_REG_ADC_CLIP] & ADAU19XX_REG_F_W), "ADC_CLIP writeable");
+    CHECK(test_reg_flags[ADAU19XX_REG_STATUS(0)] & ADAU19XX_REG_F_1977, "STATUS(0) not 1977 only");
+
+    //看门狗和上电流程依赖的寄存器所有型号都有
+    CHECK(!(test_reg_flags[ADAU19XX_REG_POWER] & ADAU19XX_REG_F_1977), "POWER 1977 only");
+    CHECK(!(test_reg_flags[ADAU19XX_REG_PLL] & ADAU19XX_REG_F_1977), "PLL 1977 only");
+    CHECK(!(test_reg_flags[ADAU19XX_REG_SAI_CTRL0] & ADAU19XX_REG_F_1977), "SAI_CTRL0 1977 only");
+    CHECK(test_reg_defs[ADAU19XX_REG_PLL] == 0x41, "PLL default 0x%02x, power-up rewrites 0x41",
+            test_reg_defs[ADAU19XX_REG_PLL]);
+}
+
+static void test_owned_bits(void) {
+    unsigned int reg;
+
+    CHECK(adau19xx_reg_owned_bits(ADAU19XX_REG_POWER) == 0xff, "POWER not fully owned");
+    CHECK(adau19xx_reg_owned_bits(ADAU19XX_REG_MISC_CONTROL) & ADAU19XX_MISC_CONTROL_DC_CAL, "DC_CAL not owned");
+    CHECK(adau19xx_reg_owned_bits(ADAU19XX_REG_MISC_CONTROL) & ADAU19XX_MISC_CONTROL_MMUTE, "MMUTE not owned");
+    CHECK(!(adau19xx_reg_owned_bits(ADAU19XX_REG_MISC_CONTROL) & ADAU19XX_MISC_CONTROL_SUM_MODE_MASK),
+            "SUM_MODE owned");
+    CHECK(adau19xx_reg_owned_bits(ADAU19XX_REG_BLOCK_POWER_SAI) == 0x1f, "BLOCK_POWER_SAI owned 0x%02x",
+            adau19xx_reg_owned_bits(ADAU19XX_REG_BLOCK_POWER_SAI));
+
+    for (reg = 0; reg < 4; reg++)
+        CHECK(adau19xx_reg_owned_bits(ADAU19XX_REG_POST_ADC_GAIN(reg)) == 0, "gain %u owned", reg);
+}
+
+int main(void) {
+    test_lookup_fs();
+    test_calc_mcs();
+    test_sysclk_matches_mcs();
+    test_reg_table_once();
+    test_reg_table();
+    test_owned_bits();
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,597 @@
+#ifndef _ADAU19XX_HOST_H
+#define _ADAU19XX_HOST_H
+
+//在主机上编译adau19xx.h/adau19xx.c所需的最小内核接口,只用于driver/test,不参与驱动编译
+//类型和宏只保留驱动用到的成员;函数的实现(寄存器映射模型、设备属性、ASoC登记等)在adau19xx-host.c
+//单线程运行:锁只检查加锁/解锁是否配对,延迟不等待,延迟任务由测试显式执行
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int16_t s16;
+typedef int64_t s64;
+typedef s64 ktime_t;
+typedef unsigned int gfp_t;
+
+#define BIT(nr) (1UL << (nr))
+#define BIT_ULL(nr) (1ULL << (nr))
+#define ARRAY_SIZE(arr) (sizeof (arr) / sizeof ((arr)[0]))
+#define BUILD_BUG_ON(cond) _Static_assert(!(cond), #cond)
+#define READ_ONCE(x) (x)
+#define WRITE_ONCE(x, val) ((x) = (val))
+#define container_of(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+
+#define IS_ERR(ptr) ((unsigned long)(ptr) >= (unsigned long)-4095)
+#define PTR_ERR(ptr) ((long)(ptr))
+
+//模块相关声明在主机上没有意义
+#define EXPORT_SYMBOL_GPL(sym) extern int adau19xx_host_export
+#define MODULE_DESCRIPTION(str) extern int adau19xx_host_module
+#define MODULE_AUTHOR(str) extern int adau19xx_host_module
+#define MODULE_LICENSE(str) extern int adau19xx_host_module
+#define __init
+#define __exit
+
+typedef struct { int counter; } atomic_t;
+
+//锁:重复加锁或解锁未持有的锁时测试立即失败
+struct mutex {
+    int locked;
+};
+
+#define DEFINE_MUTEX(name) struct mutex name = { 0 }
+
+extern void mutex_init(struct mutex *lock);
+extern void mutex_lock(struct mutex *lock);
+extern void mutex_unlock(struct mutex *lock);
+#define mutex_lock_nested(lock, subclass) mutex_lock(lock)
+
+typedef struct { int locked; } spinlock_t;
+
+static inline void spin_lock_init(spinlock_t *lock) {
+    lock->locked = 0;
+}
+
+//链表,与内核list.h行为一致
+struct list_head {
+    struct list_head *next, *prev;
+};
+
+#define LIST_HEAD_INIT(name) { &(name), &(name) }
+#define LIST_HEAD(name) struct list_head name = LIST_HEAD_INIT(name)
+
+static inline void INIT_LIST_HEAD(struct list_head *list) {
+    list->next = list;
+    list->prev = list;
+}
+
+static inline void list_add_tail(struct list_head *entry, struct list_head *head) {
+    entry->prev = head->prev;
+    entry->next = head;
+    head->prev->next = entry;
+    head->prev = entry;
+}
+
+static inline void list_del(struct list_head *entry) {
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+    entry->next = NULL;
+    entry->prev = NULL;
+}
+
+static inline bool list_empty(const struct list_head *head) {
+    return head->next == head;
+}
+
+#define list_entry(ptr, type, member) container_of(ptr, type, member)
+#define list_for_each_entry(pos, head, member) \
+    for (pos = list_entry((head)->next, __typeof__(*pos), member); \
+            &pos->member != (head); \
+            pos = list_entry(pos->member.next, __typeof__(*pos), member))
+
+//时间:ktime_get按调用次数每次前进1us,耗时统计有确定的非零值
+extern ktime_t ktime_get(void);
+#define ktime_get_boottime() ktime_get()
+
+static inline s64 ktime_us_delta(ktime_t later, ktime_t earlier) {
+    return (later - earlier) / 1000;
+}
+
+static inline unsigned long msecs_to_jiffies(unsigned int ms) {
+    return ms;
+}
+
+static inline void udelay(unsigned long us) {
+}
+
+static inline void mdelay(unsigned long ms) {
+}
+
+static inline void msleep(unsigned int ms) {
+}
+
+static inline void usleep_range(unsigned long min, unsigned long max) {
+}
+
+//轮询不等待,按timeout_us / sleep_us折算成最多读取的次数
+#define readx_poll_timeout(op, addr, val, cond, sleep_us, timeout_us) ({ \
+    unsigned long __left = (timeout_us) / ((sleep_us) ? (sleep_us) : 1) + 1; \
+    for (;;) { \
+        (val) = op(addr); \
+        if ((cond) || !--__left) \
+            break; \
+    } \
+    (cond) ? 0 : -ETIMEDOUT; \
+})
+
+//延迟任务:只记录是否已排队,由测试调用host_run_delayed_work执行
+struct work_struct {
+    void (*func)(struct work_struct *work);
+};
+
+struct delayed_work {
+    struct work_struct work;
+    bool pending;
+    unsigned long delay;
+};
+
+#define INIT_DELAYED_WORK(dwork, fn) do { \
+    (dwork)->work.func = (fn); \
+    (dwork)->pending = false; \
+} while (0)
+
+static inline struct delayed_work *to_delayed_work(struct work_struct *work) {
+    return container_of(work, struct delayed_work, work);
+}
+
+static inline bool schedule_delayed_work(struct delayed_work *dwork, unsigned long delay) {
+    if (dwork->pending)
+        return false;
+    dwork->pending = true;
+    dwork->delay = delay;
+    return true;
+}
+
+static inline bool cancel_delayed_work(struct delayed_work *dwork) {
+    bool pending = dwork->pending;
+
+    dwork->pending = false;
+    return pending;
+}
+
+#define cancel_delayed_work_sync(dwork) cancel_delayed_work(dwork)
+#define delayed_work_pending(dwork) ((dwork)->pending)
+
+extern bool host_run_delayed_work(struct delayed_work *dwork);
+
+//内存:devm_*分配随进程结束释放
+#define GFP_KERNEL 0
+extern void *kzalloc(size_t size, gfp_t flags);
+extern void *kcalloc(size_t n, size_t size, gfp_t flags);
+extern void kfree(const void *ptr);
+
+//设备与属性:属性表以{名称, u32数组}给出,同时充当设备树节点和设备属性
+struct host_property {
+    const char *name;
+    const u32 *vals; //NULL表示布尔属性
+    int num;
+};
+
+struct device_node {
+    const struct host_property *props;
+};
+
+#define HOST_DEV_ACTIONS 8
+
+struct device {
+    const char *name;
+    struct device_node *of_node;
+    void *driver_data;
+    void (*actions[HOST_DEV_ACTIONS])(void *data); //devm_add_action_or_reset登记的释放动作
+    void *action_data[HOST_DEV_ACTIONS];
+    unsigned int num_actions;
+};
+
+static inline void *dev_get_drvdata(const struct device *dev) {
+    return dev->driver_data;
+}
+
+static inline void dev_set_drvdata(struct device *dev, void *data) {
+    dev->driver_data = data;
+}
+
+static inline const char *dev_name(const struct device *dev) {
+    return dev->name;
+}
+
+extern void *devm_kzalloc(struct device *dev, size_t size, gfp_t flags);
+extern void *devm_kcalloc(struct device *dev, size_t n, size_t size, gfp_t flags);
+extern int devm_add_action_or_reset(struct device *dev, void (*action)(void *data), void *data);
+extern void host_device_unbind(struct device *dev); //按登记的逆序执行释放动作
+
+//日志:dev_err/dev_warn/pr_warn的最后一条保存在host_last_msg,测试可检查错误原因
+extern char host_last_msg[256];
+extern void host_printk(int level, const struct device *dev, const char *fmt, ...)
+        __attribute__((format(printf, 3, 4)));
+#define dev_dbg(dev, ...) host_printk(3, dev, __VA_ARGS__)
+#define dev_info(dev, ...) host_printk(2, dev, __VA_ARGS__)
+#define dev_warn(dev, ...) host_printk(1, dev, __VA_ARGS__)
+#define dev_err(dev, ...) host_printk(0, dev, __VA_ARGS__)
+#define pr_warn(...) host_printk(1, NULL, __VA_ARGS__)
+
+extern int of_property_read_u32(const struct device_node *np, const char *propname, u32 *out);
+extern bool of_property_read_bool(const struct device_node *np, const char *propname);
+extern int of_property_count_u32_elems(const struct device_node *np, const char *propname);
+extern int of_property_read_u32_array(const struct device_node *np, const char *propname, u32 *out, size_t sz);
+extern int device_property_read_u32(struct device *dev, const char *propname, u32 *val);
+
+//复位GPIO:主机上没有,devm_gpiod_get_optional始终返回NULL
+struct gpio_desc;
+
+enum gpiod_flags {
+    GPIOD_OUT_LOW,
+};
+
+static inline struct gpio_desc *devm_gpiod_get_optional(struct device *dev, const char *con_id,
+        enum gpiod_flags flags) {
+    return NULL;
+}
+
+static inline void gpiod_set_value_cansleep(struct gpio_desc *desc, int value) {
+}
+
+//regmap:缓存和硬件各一份寄存器映像,行为按内核4.14的regmap/regcache实现,见adau19xx-host.c
+enum regcache_type {
+    REGCACHE_NONE,
+    REGCACHE_RBTREE,
+    REGCACHE_COMPRESSED,
+    REGCACHE_FLAT,
+};
+
+struct reg_default {
+    unsigned int reg;
+    unsigned int def;
+};
+
+struct reg_sequence {
+    unsigned int reg;
+    unsigned int def;
+    unsigned int delay_us;
+};
+
+struct regmap_config {
+    const char *name;
+    int reg_bits;
+    int val_bits;
+    unsigned int max_register;
+    bool (*readable_reg)(struct device *dev, unsigned int reg);
+    bool (*writeable_reg)(struct device *dev, unsigned int reg);
+    bool (*volatile_reg)(struct device *dev, unsigned int reg);
+    enum regcache_type cache_type;
+    const struct reg_default *reg_defaults;
+    unsigned int num_reg_defaults;
+    unsigned long read_flag_mask;
+};
+
+#define HOST_REGMAP_REGS 256
+
+struct regmap;
+
+//总线传输计数,每次对硬件的单个或连续读写计一次
+enum host_xfer {
+    HOST_XFER_READ,
+    HOST_XFER_WRITE,
+    HOST_XFER_NUM,
+};
+
+struct regmap {
+    struct device *dev;
+    const struct regmap_config *config;
+    unsigned int cache[HOST_REGMAP_REGS];
+    bool present[HOST_REGMAP_REGS]; //缓存中有值
+    bool cache_only;
+    bool cache_bypass;
+    bool cache_dirty;
+    bool no_sync_defaults; //regcache_mark_dirty后,同步时跳过与默认值相同的寄存器
+
+    u8 hw[HOST_REGMAP_REGS]; //芯片寄存器
+    void (*hw_write)(struct regmap *map, unsigned int reg, unsigned int val); //芯片写入行为,NULL=直接保存
+    unsigned int xfers[HOST_XFER_NUM];
+    unsigned int hw_writes[HOST_REGMAP_REGS]; //每个寄存器在总线上被写的次数
+    unsigned int delay_us; //reg_sequence中累计的延时
+    unsigned int warnings; //违反regmap使用约束的次数(内核中为WARN_ON)
+};
+
+extern struct regmap *host_regmap_init(struct device *dev, const struct regmap_config *config);
+extern void host_regmap_clear_stats(struct regmap *map);
+extern int host_regmap_hw_read(struct regmap *map, unsigned int reg, u8 *buf, size_t count);
+
+extern int regmap_read(struct regmap *map, unsigned int reg, unsigned int *val);
+extern int regmap_write(struct regmap *map, unsigned int reg, unsigned int val);
+extern int regmap_update_bits(struct regmap *map, unsigned int reg, unsigned int mask, unsigned int val);
+extern int regmap_multi_reg_write_bypassed(struct regmap *map, const struct reg_sequence *regs, int num_regs);
+extern void regcache_cache_only(struct regmap *map, bool enable);
+extern void regcache_cache_bypass(struct regmap *map, bool enable);
+extern void regcache_mark_dirty(struct regmap *map);
+extern int regcache_sync(struct regmap *map);
+extern int regcache_sync_region(struct regmap *map, unsigned int min, unsigned int max);
+
+//PCM
+#define SNDRV_PCM_RATE_KNOT (1U << 31)
+#define SNDRV_PCM_FMTBIT_S16_LE (1ULL << 2)
+#define SNDRV_PCM_FMTBIT_S32_LE (1ULL << 10)
+#define SNDRV_PCM_HW_PARAM_RATE 11
+
+struct snd_pcm_hw_constraint_list {
+    const unsigned int *list;
+    unsigned int count;
+    unsigned int mask;
+};
+
+struct snd_pcm_runtime {
+    const struct snd_pcm_hw_constraint_list *rate_list;
+    unsigned int rate_min;
+    unsigned int rate_max;
+};
+
+struct snd_pcm_substream {
+    struct snd_pcm_runtime *runtime;
+};
+
+struct snd_pcm_hw_params {
+    unsigned int rate;
+    unsigned int width;
+};
+
+static inline unsigned int params_rate(const struct snd_pcm_hw_params *params) {
+    return params->rate;
+}
+
+static inline int params_width(const struct snd_pcm_hw_params *params) {
+    return params->width;
+}
+
+static inline int snd_pcm_hw_constraint_list(struct snd_pcm_runtime *runtime, unsigned int cond,
+        int var, const struct snd_pcm_hw_constraint_list *l) {
+    runtime->rate_list = l;
+    return 0;
+}
+
+static inline int snd_pcm_hw_constraint_minmax(struct snd_pcm_runtime *runtime, int var,
+        unsigned int min, unsigned int max) {
+    runtime->rate_min = min;
+    runtime->rate_max = max;
+    return 0;
+}
+
+//控件
+struct snd_kcontrol;
+
+struct snd_ctl_elem_value {
+    union {
+        struct {
+            long value[128];
+        } integer;
+        struct {
+            unsigned int item[128];
+        } enumerated;
+    } value;
+};
+
+typedef int (snd_kcontrol_get_t)(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol);
+typedef int (snd_kcontrol_put_t)(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol);
+
+struct snd_kcontrol_new {
+    const char *name;
+    snd_kcontrol_get_t *get;
+    snd_kcontrol_put_t *put;
+    unsigned long private_value;
+    const unsigned int *tlv;
+};
+
+struct snd_kcontrol {
+    const struct snd_kcontrol_new *new;
+    void *private_data; //所属codec
+};
+
+struct soc_enum {
+    int reg;
+    unsigned char shift_l;
+    unsigned char shift_r;
+    unsigned int items;
+    unsigned int mask;
+    const char *const *texts;
+    const unsigned int *values;
+    unsigned int autodisable;
+};
+
+#define DECLARE_TLV_DB_MINMAX_MUTE(name, min_dB, max_dB) unsigned int name[] = { 0, 0, (min_dB), (max_dB) }
+#define SOC_SINGLE(xname, reg, shift, max, invert) \
+    { .name = (xname), .private_value = (reg) | ((shift) << 8) | ((max) << 16) }
+#define SOC_SINGLE_TLV(xname, reg, shift, max, invert, tlv_array) \
+    { .name = (xname), .private_value = (reg) | ((shift) << 8) | ((max) << 16), .tlv = (tlv_array) }
+#define SOC_SINGLE_BOOL_EXT(xname, xdata, xhandler_get, xhandler_put) \
+    { .name = (xname), .get = (xhandler_get), .put = (xhandler_put), .private_value = (xdata) }
+#define SOC_ENUM_SINGLE(xreg, xshift, xitems, xtexts) \
+    { .reg = (xreg), .shift_l = (xshift), .shift_r = (xshift), .items = (xitems), .texts = (xtexts) }
+#define SOC_ENUM(xname, xenum) { .name = (xname), .private_value = (unsigned long)&(xenum) }
+
+//DAPM:测试按名称查找部件并模拟上下电
+#define SND_SOC_NOPM -1
+#define SND_SOC_DAPM_PRE_PMU 0x1
+#define SND_SOC_DAPM_POST_PMU 0x2
+#define SND_SOC_DAPM_PRE_PMD 0x4
+#define SND_SOC_DAPM_POST_PMD 0x8
+#define SND_SOC_DAPM_EVENT_ON(e) ((e) & (SND_SOC_DAPM_PRE_PMU | SND_SOC_DAPM_POST_PMU))
+
+struct snd_soc_dapm_context;
+
+struct snd_soc_dapm_widget {
+    const char *name;
+    const char *sname;
+    int reg;
+    unsigned char shift;
+    unsigned char invert;
+    int subseq;
+    int (*event)(struct snd_soc_dapm_widget *w, struct snd_kcontrol *kcontrol, int event);
+    unsigned short event_flags;
+    struct snd_soc_dapm_context *dapm;
+};
+
+#define SND_SOC_DAPM_INPUT(wname) { .name = (wname), .reg = SND_SOC_NOPM }
+#define SND_SOC_DAPM_OUTPUT(wname) { .name = (wname), .reg = SND_SOC_NOPM }
+#define SND_SOC_DAPM_SUPPLY(wname, wreg, wshift, winvert, wevent, wflags) \
+    { .name = (wname), .reg = (wreg), .shift = (wshift), .invert = (winvert), \
+      .event = (wevent), .event_flags = (wflags) }
+#define SND_SOC_DAPM_SUPPLY_S(wname, wsubseq, wreg, wshift, winvert, wevent, wflags) \
+    { .name = (wname), .subseq = (wsubseq), .reg = (wreg), .shift = (wshift), .invert = (winvert), \
+      .event = (wevent), .event_flags = (wflags) }
+#define SND_SOC_DAPM_ADC_E(wname, stname, wreg, wshift, winvert, wevent, wflags) \
+    { .name = (wname), .sname = (stname), .reg = (wreg), .shift = (wshift), .invert = (winvert), \
+      .event = (wevent), .event_flags = (wflags) }
+
+struct snd_soc_dapm_route {
+    const char *sink;
+    const char *control;
+    const char *source;
+};
+
+#define HOST_DAPM_WIDGETS 16
+
+struct snd_soc_dapm_context {
+    struct snd_soc_codec *codec;
+    struct snd_soc_dapm_widget widgets[HOST_DAPM_WIDGETS]; //snd_soc_dapm_new_controls复制的部件
+    unsigned int num_widgets;
+    unsigned int num_routes;
+};
+
+//ASoC
+enum snd_soc_bias_level {
+    SND_SOC_BIAS_OFF = 0,
+    SND_SOC_BIAS_STANDBY = 1,
+    SND_SOC_BIAS_PREPARE = 2,
+    SND_SOC_BIAS_ON = 3,
+};
+
+#define SND_SOC_CLOCK_IN 0
+#define SND_SOC_CLOCK_OUT 1
+
+#define SND_SOC_DAIFMT_I2S 1
+#define SND_SOC_DAIFMT_RIGHT_J 2
+#define SND_SOC_DAIFMT_LEFT_J 3
+#define SND_SOC_DAIFMT_DSP_A 4
+#define SND_SOC_DAIFMT_DSP_B 5
+#define SND_SOC_DAIFMT_NB_NF (0 << 8)
+#define SND_SOC_DAIFMT_NB_IF (2 << 8)
+#define SND_SOC_DAIFMT_IB_NF (3 << 8)
+#define SND_SOC_DAIFMT_IB_IF (4 << 8)
+#define SND_SOC_DAIFMT_CBM_CFM (1 << 12)
+#define SND_SOC_DAIFMT_CBS_CFS (4 << 12)
+#define SND_SOC_DAIFMT_FORMAT_MASK 0x000f
+#define SND_SOC_DAIFMT_INV_MASK 0x0f00
+#define SND_SOC_DAIFMT_MASTER_MASK 0xf000
+
+struct snd_soc_card {
+    struct mutex dapm_mutex;
+};
+
+struct snd_soc_component {
+    struct snd_soc_card *card;
+};
+
+struct snd_soc_codec {
+    struct device *dev;
+    struct snd_soc_component component;
+    struct snd_soc_dapm_context dapm;
+    unsigned int num_controls;
+};
+
+struct snd_soc_dai {
+    struct device *dev;
+    struct snd_soc_codec *codec;
+};
+
+static inline void *snd_soc_codec_get_drvdata(const struct snd_soc_codec *codec) {
+    return dev_get_drvdata(codec->dev);
+}
+
+static inline struct snd_soc_dapm_context *snd_soc_codec_get_dapm(struct snd_soc_codec *codec) {
+    return &codec->dapm;
+}
+
+static inline struct snd_soc_codec *snd_soc_dapm_to_codec(struct snd_soc_dapm_context *dapm) {
+    return dapm->codec;
+}
+
+static inline struct snd_soc_codec *snd_soc_kcontrol_codec(struct snd_kcontrol *kcontrol) {
+    return kcontrol->private_data;
+}
+
+struct snd_soc_pcm_stream {
+    const char *stream_name;
+    u64 formats;
+    unsigned int rates;
+    unsigned int channels_min;
+    unsigned int channels_max;
+    unsigned int sig_bits;
+};
+
+struct snd_soc_dai_ops {
+    int (*set_sysclk)(struct snd_soc_dai *dai, int clk_id, unsigned int freq, int dir);
+    int (*set_fmt)(struct snd_soc_dai *dai, unsigned int fmt);
+    int (*startup)(struct snd_pcm_substream *substream, struct snd_soc_dai *dai);
+    void (*shutdown)(struct snd_pcm_substream *substream, struct snd_soc_dai *dai);
+    int (*hw_params)(struct snd_pcm_substream *substream, struct snd_pcm_hw_params *params,
+            struct snd_soc_dai *dai);
+    int (*hw_free)(struct snd_pcm_substream *substream, struct snd_soc_dai *dai);
+    int (*mute_stream)(struct snd_soc_dai *dai, int mute, int stream);
+};
+
+struct snd_soc_dai_driver {
+    const char *name;
+    struct snd_soc_pcm_stream capture;
+    const struct snd_soc_dai_ops *ops;
+};
+
+struct snd_soc_codec_driver {
+    int (*probe)(struct snd_soc_codec *codec);
+    int (*set_bias_level)(struct snd_soc_codec *codec, enum snd_soc_bias_level level);
+    bool idle_bias_off;
+};
+
+//snd_soc_register_codec登记的驱动,测试据此创建codec和dai
+struct host_codec_reg {
+    struct device *dev;
+    const struct snd_soc_codec_driver *driver;
+    struct snd_soc_dai_driver *dai;
+};
+
+extern struct host_codec_reg host_codecs[4];
+extern unsigned int host_num_codecs;
+
+extern int snd_soc_register_codec(struct device *dev, const struct snd_soc_codec_driver *codec_drv,
+        struct snd_soc_dai_driver *dai_drv, int num_dai);
+extern int snd_soc_add_codec_controls(struct snd_soc_codec *codec, const struct snd_kcontrol_new *controls,
+        unsigned int num_controls);
+extern int snd_soc_dapm_new_controls(struct snd_soc_dapm_context *dapm,
+        const struct snd_soc_dapm_widget *widget, int num);
+extern int snd_soc_dapm_add_routes(struct snd_soc_dapm_context *dapm,
+        const struct snd_soc_dapm_route *route, int num);
+
+//电源管理
+struct dev_pm_ops {
+    int (*suspend)(struct device *dev);
+    int (*resume)(struct device *dev);
+};
+
+#define SET_SYSTEM_SLEEP_PM_OPS(suspend_fn, resume_fn) .suspend = (suspend_fn), .resume = (resume_fn),
+
+struct dentry;
+
+#endif
@@ -0,0 +1 @@
+#include "../adau19xx-host.h"
@@ -18,6 +18,11 @@ if [ -f /lib/modules/${uname_r}/kernel/sound/soc/codecs/snd-soc-adau19xx.ko ] ;
   rm  /lib/modules/${uname_r}/kernel/sound/soc/codecs/snd-soc-adau19xx.ko
 fi
 
+if [ -f /lib/modules/${uname_r}/kernel/sound/soc/codecs/snd-soc-adau19xx-spi.ko ] ; then
+  echo "remove snd-soc-adau19xx-spi.ko"
+  rm  /lib/modules/${uname_r}/kernel/sound/soc/codecs/snd-soc-adau19xx-spi.ko
+fi
+
 if [ -d /var/lib/dkms/adau19xx ] ; then
   echo "remove adau19xx dkms"
   rm  -rf  /var/lib/dkms/adau19xx
@@ -17,6 +17,12 @@ dtc -@ -I dts -O dtb -o adau19xx-2ch.dtbo adau19xx-2ch-overlay.dts
 #mclk mode
 #dtc -@ -I dts -O dtb -o adau19xx-2ch-mclk.dtbo adau19xx-2ch-overlay-mclk.dts
 
+#codec master mode
+#dtc -@ -I dts -O dtb -o adau19xx-2ch-master.dtbo adau19xx-2ch-overlay-master.dts
+
+#spi mode
+#dtc -@ -I dts -O dtb -o adau19xx-2ch-spi.dtbo adau19xx-2ch-overlay-spi.dts
+
 echo "copy dtbo file to /boot/overlays"
 rm -f /boot/overlays/adau19xx-2ch.dtbo
 cp adau19xx-2ch.dtbo /boot/overlays
@@ -0,0 +1,333 @@
+//adau19xx声卡录音基准测试
+//遍历采样率/格式/声道数/周期大小组合,每组记录:
+//  open_us          snd_pcm_open耗时
+//  hw_params_us     snd_pcm_hw_params耗时(驱动的hw_params、上电等)
+//  first_sample_us  从打开到第一个采样点被采集的耗时:读到第一个周期的时刻减去一个理论周期,
+//                   周期中断到来前数据不可读,直接计时会多出整整一个周期
+//  xruns            测试时长内的溢出次数
+//  jitter_*_us      相邻两次周期唤醒间隔与理论周期之差的平均/p99/最大值
+//  cpu_pct          本进程用户态+内核态CPU占用
+//status为unsupported表示设备不支持该组参数,其他失败状态在error中给出错误码
+//输出CSV或JSON,可对snd-aloop/snd-dummy运行,没有芯片时也能开发:
+//  ./adau19xx-bench -D hw:Dummy -o json
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include <alsa/asoundlib.h>
+
+#define BENCH_MAX_ITEMS 32
+
+//与驱动adau19xx_rates对应的标准采样率
+static const char *default_rates = "8000,11025,12000,16000,22050,24000,32000,44100,48000,64000,88200,96000,128000,176400,192000";
+
+struct bench_opts {
+    const char *device;
+    unsigned int rates[BENCH_MAX_ITEMS];
+    int num_rates;
+    snd_pcm_format_t formats[BENCH_MAX_ITEMS];
+    int num_formats;
+    unsigned int channels[BENCH_MAX_ITEMS];
+    int num_channels;
+    unsigned int periods_size[BENCH_MAX_ITEMS];
+    int num_periods_size;
+    unsigned int periods; //每个缓冲区的周期数
+    double duration; //每组测试时长,秒
+    int json;
+};
+
+struct bench_result {
+    unsigned int rate;
+    snd_pcm_format_t format;
+    unsigned int channels;
+    snd_pcm_uframes_t period_size;
+    snd_pcm_uframes_t buffer_size;
+    const char *status;
+    int error; //失败时的错误码
+    double open_us;
+    double hw_params_us;
+    double first_sample_us;
+    unsigned int xruns;
+    unsigned int wakeups;
+    double jitter_avg_us;
+    double jitter_p99_us;
+    double jitter_max_us;
+    double cpu_pct;
+};
+
+static double now_us(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static double cpu_us(void) {
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e6 + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double da = *(const double *) a, db = *(const double *) b;
+
+    return da < db ? -1 : da > db;
+}
+
+static int parse_uint_list(const char *arg, unsigned int *out) {
+    char *buf = strdup(arg), *tok, *save = NULL;
+    int n = 0;
+
+    for (tok = strtok_r(buf, ",", &save); tok && n < BENCH_MAX_ITEMS; tok = strtok_r(NULL, ",", &save))
+        out[n++] = strtoul(tok, NULL, 0);
+    free(buf);
+    return n;
+}
+
+static int parse_format_list(const char *arg, snd_pcm_format_t *out) {
+    char *buf = strdup(arg), *tok, *save = NULL;
+    int n = 0;
+
+    for (tok = strtok_r(buf, ",", &save); tok && n < BENCH_MAX_ITEMS; tok = strtok_r(NULL, ",", &save)) {
+        out[n] = snd_pcm_format_value(tok);
+        if (out[n] == SND_PCM_FORMAT_UNKNOWN) {
+            fprintf(stderr, "unknown format %s\n", tok);
+            free(buf);
+            return -1;
+        }
+        n++;
+    }
+    free(buf);
+    return n;
+}
+
+//参数组合被设备拒绝时返回1,snd_pcm_hw_params失败返回错误码
+static int bench_set_params(snd_pcm_t *pcm, struct bench_result *res, unsigned int periods) {
+    snd_pcm_hw_params_t *hw;
+    snd_pcm_uframes_t period = res->period_size;
+    unsigned int rate = res->rate;
+    double t;
+    int ret;
+
+    snd_pcm_hw_params_alloca(&hw);
+    snd_pcm_hw_params_any(pcm, hw);
+    if (snd_pcm_hw_params_set_access(pcm, hw, SND_PCM_ACCESS_RW_INTERLEAVED) < 0 ||
+            snd_pcm_hw_params_set_format(pcm, hw, res->format) < 0 ||
+            snd_pcm_hw_params_set_channels(pcm, hw, res->channels) < 0 ||
+            snd_pcm_hw_params_set_rate(pcm, hw, rate, 0) < 0)
+        return 1;
+    snd_pcm_hw_params_set_period_size_near(pcm, hw, &period, NULL);
+    snd_pcm_hw_params_set_periods_near(pcm, hw, &periods, NULL);
+
+    t = now_us();
+    ret = snd_pcm_hw_params(pcm, hw);
+    res->hw_params_us = now_us() - t;
+    if (ret < 0)
+        return ret;
+
+    snd_pcm_hw_params_get_period_size(hw, &res->period_size, NULL);
+    snd_pcm_hw_params_get_buffer_size(hw, &res->buffer_size);
+    return 0;
+}
+
+//一组参数:打开、设置、读取duration秒,统计唤醒间隔
+static void bench_run(const struct bench_opts *opts, struct bench_result *res) {
+    snd_pcm_t *pcm;
+    double t_open, t_prev, t, nominal, cpu0, wall0, sum = 0;
+    double *dev = NULL;
+    unsigned int max_wakeups, i;
+    char *buf = NULL;
+    snd_pcm_sframes_t n;
+    int ret;
+
+    res->status = "ok";
+    t_open = now_us();
+    ret = snd_pcm_open(&pcm, opts->device, SND_PCM_STREAM_CAPTURE, 0);
+    res->open_us = now_us() - t_open;
+    if (ret < 0) {
+        res->status = "open_failed";
+        res->error = ret;
+        return;
+    }
+
+    ret = bench_set_params(pcm, res, opts->periods);
+    if (ret) {
+        res->status = ret > 0 ? "unsupported" : "hw_params_failed";
+        res->error = ret > 0 ? 0 : ret;
+        goto out;
+    }
+
+    buf = malloc(snd_pcm_frames_to_bytes(pcm, res->period_size));
+    nominal = res->period_size * 1e6 / res->rate;
+    max_wakeups = opts->duration * 1e6 / nominal + 2;
+    dev = calloc(max_wakeups, sizeof (*dev));
+    if (!buf || !dev) {
+        res->status = "nomem";
+        goto out;
+    }
+
+    n = snd_pcm_readi(pcm, buf, res->period_size);
+    if (n < 0) {
+        res->status = "read_failed";
+        res->error = n;
+        goto out;
+    }
+    t_prev = now_us();
+    res->first_sample_us = t_prev - t_open - nominal;
+
+    cpu0 = cpu_us();
+    wall0 = t_prev;
+    while (res->wakeups < max_wakeups && t_prev - wall0 < opts->duration * 1e6) {
+        n = snd_pcm_readi(pcm, buf, res->period_size);
+        t = now_us();
+        if (n == -EPIPE) {
+            res->xruns++;
+            snd_pcm_recover(pcm, n, 1);
+            t_prev = t;
+            continue;
+        }
+        if (n < 0) {
+            res->status = "read_failed";
+            res->error = n;
+            break;
+        }
+        dev[res->wakeups] = t - t_prev > nominal ? t - t_prev - nominal : nominal - (t - t_prev);
+        sum += dev[res->wakeups];
+        res->wakeups++;
+        t_prev = t;
+    }
+    if (t_prev > wall0)
+        res->cpu_pct = (cpu_us() - cpu0) * 100 / (t_prev - wall0);
+
+    if (res->wakeups) {
+        qsort(dev, res->wakeups, sizeof (*dev), cmp_double);
+        res->jitter_avg_us = sum / res->wakeups;
+        i = res->wakeups * 99 / 100;
+        res->jitter_p99_us = dev[i < res->wakeups ? i : res->wakeups - 1];
+        res->jitter_max_us = dev[res->wakeups - 1];
+    }
+
+out:
+    free(dev);
+    free(buf);
+    snd_pcm_close(pcm);
+}
+
+static void print_header(const struct bench_opts *opts) {
+    if (opts->json)
+        printf("[\n");
+    else
+        printf("device,rate,format,channels,period_size,buffer_size,status,error,open_us,hw_params_us,"
+                "first_sample_us,xruns,wakeups,jitter_avg_us,jitter_p99_us,jitter_max_us,cpu_pct\n");
+}
+
+static void print_result(const struct bench_opts *opts, const struct bench_result *r, int first) {
+    if (opts->json) {
+        printf("%s  {\"device\": \"%s\", \"rate\": %u, \"format\": \"%s\", \"channels\": %u, "
+                "\"period_size\": %lu, \"buffer_size\": %lu, \"status\": \"%s\", \"error\": %d, "
+                "\"open_us\": %.1f, \"hw_params_us\": %.1f, \"first_sample_us\": %.1f, "
+                "\"xruns\": %u, \"wakeups\": %u, \"jitter_avg_us\": %.1f, \"jitter_p99_us\": %.1f, "
+                "\"jitter_max_us\": %.1f, \"cpu_pct\": %.2f}",
+                first ? "" : ",\n", opts->device, r->rate, snd_pcm_format_name(r->format), r->channels,
+                (unsigned long) r->period_size, (unsigned long) r->buffer_size, r->status, r->error,
+                r->open_us, r->hw_params_us, r->first_sample_us, r->xruns, r->wakeups,
+                r->jitter_avg_us, r->jitter_p99_us, r->jitter_max_us, r->cpu_pct);
+    } else {
+        printf("%s,%u,%s,%u,%lu,%lu,%s,%d,%.1f,%.1f,%.1f,%u,%u,%.1f,%.1f,%.1f,%.2f\n",
+                opts->device, r->rate, snd_pcm_format_name(r->format), r->channels,
+                (unsigned long) r->period_size, (unsigned long) r->buffer_size, r->status, r->error,
+                r->open_us, r->hw_params_us, r->first_sample_us, r->xruns, r->wakeups,
+                r->jitter_avg_us, r->jitter_p99_us, r->jitter_max_us, r->cpu_pct);
+    }
+    fflush(stdout);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -D device    PCM device, default hw:adau19xxcard\n"
+            "  -r rates     comma separated, default all adau19xx rates\n"
+            "  -f formats   comma separated, default S16_LE,S32_LE\n"
+            "  -c channels  comma separated, default 1,2\n"
+            "  -p periods   period sizes in frames, default 256,1024\n"
+            "  -n count     periods per buffer, default 4\n"
+            "  -d seconds   duration of each case, default 2\n"
+            "  -o csv|json  output format, default csv\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    struct bench_opts opts = {
+        .device = "hw:adau19xxcard",
+        .periods = 4,
+        .duration = 2,
+    };
+    struct bench_result res;
+    int r, f, c, p, opt, first = 1;
+
+    opts.num_rates = parse_uint_list(default_rates, opts.rates);
+    opts.num_formats = parse_format_list("S16_LE,S32_LE", opts.formats);
+    opts.num_channels = parse_uint_list("1,2", opts.channels);
+    opts.num_periods_size = parse_uint_list("256,1024", opts.periods_size);
+
+    while ((opt = getopt(argc, argv, "D:r:f:c:p:n:d:o:h")) != -1) {
+        switch (opt) {
+            case 'D':
+                opts.device = optarg;
+                break;
+            case 'r':
+                opts.num_rates = parse_uint_list(optarg, opts.rates);
+                break;
+            case 'f':
+                opts.num_formats = parse_format_list(optarg, opts.formats);
+                if (opts.num_formats < 0)
+                    return 1;
+                break;
+            case 'c':
+                opts.num_channels = parse_uint_list(optarg, opts.channels);
+                break;
+            case 'p':
+                opts.num_periods_size = parse_uint_list(optarg, opts.periods_size);
+                break;
+            case 'n':
+                opts.periods = strtoul(optarg, NULL, 0);
+                break;
+            case 'd':
+                opts.duration = strtod(optarg, NULL);
+                break;
+            case 'o':
+                opts.json = !strcmp(optarg, "json");
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    print_header(&opts);
+    for (r = 0; r < opts.num_rates; r++) {
+        for (f = 0; f < opts.num_formats; f++) {
+            for (c = 0; c < opts.num_channels; c++) {
+                for (p = 0; p < opts.num_periods_size; p++) {
+                    memset(&res, 0, sizeof (res));
+                    res.rate = opts.rates[r];
+                    res.format = opts.formats[f];
+                    res.channels = opts.channels[c];
+                    res.period_size = opts.periods_size[p];
+                    bench_run(&opts, &res);
+                    print_result(&opts, &res, first);
+                    first = 0;
+                }
+            }
+        }
+    }
+    if (opts.json)
+        printf("\n]\n");
+
+    return 0;
+}
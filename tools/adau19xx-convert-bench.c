@@ -0,0 +1,181 @@
+//adau19xx-convert微基准:先把每个实现与标量实现逐位比对(含各种尾部长度和1~16声道),
+//再按192kHz多声道录音的块大小计时,输出每个采样点耗时和相对标量的加速比
+//  ./adau19xx-convert-bench [每项计时毫秒数,默认200]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "adau19xx-convert.h"
+
+#define BENCH_MAX_IMPLS 4
+#define BENCH_MAX_CHANNELS 16
+#define BENCH_BLOCK_FRAMES 1920 //192kHz下10ms
+
+static int32_t *s32_src;
+static int16_t *s16_src;
+static float *f_dst[2];
+static uint8_t *b_dst[2];
+static int32_t *ch_dst[2][BENCH_MAX_CHANNELS];
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+//覆盖满量程、符号位和低字节非0的情况
+static void fill_random(size_t n) {
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        s32_src[i] = (int32_t) ((uint32_t) rand() << 17 ^ (uint32_t) rand() << 2 ^ (uint32_t) rand());
+        s16_src[i] = (int16_t) rand();
+    }
+    s32_src[0] = INT32_MIN;
+    s32_src[1] = INT32_MAX;
+    s16_src[0] = INT16_MIN;
+    s16_src[1] = INT16_MAX;
+}
+
+static int verify(const struct adau19xx_convert_ops *ref, const struct adau19xx_convert_ops *ops) {
+    size_t n, frames;
+    unsigned int c, k;
+    int errors = 0;
+
+    for (n = 0; n <= 200; n++) {
+        ref->s32_to_float(s32_src + 3, f_dst[0], n);
+        ops->s32_to_float(s32_src + 3, f_dst[1], n);
+        if (memcmp(f_dst[0], f_dst[1], n * sizeof (float))) {
+            printf("%s: s32_to_float mismatch n=%zu\n", ops->name, n);
+            errors++;
+        }
+
+        ref->s16_to_float(s16_src + 3, f_dst[0], n);
+        ops->s16_to_float(s16_src + 3, f_dst[1], n);
+        if (memcmp(f_dst[0], f_dst[1], n * sizeof (float))) {
+            printf("%s: s16_to_float mismatch n=%zu\n", ops->name, n);
+            errors++;
+        }
+
+        //输出缓冲区末尾放哨兵,检查没有越界写入
+        memset(b_dst[0], 0xa5, 3 * n + 64);
+        memset(b_dst[1], 0xa5, 3 * n + 64);
+        ref->s32_to_s24_3le(s32_src + 3, b_dst[0], n);
+        ops->s32_to_s24_3le(s32_src + 3, b_dst[1], n);
+        if (memcmp(b_dst[0], b_dst[1], 3 * n + 64)) {
+            printf("%s: s32_to_s24_3le mismatch n=%zu\n", ops->name, n);
+            errors++;
+        }
+    }
+
+    for (c = 1; c <= BENCH_MAX_CHANNELS; c++) {
+        for (frames = 0; frames <= 40; frames++) {
+            for (k = 0; k < c; k++) {
+                memset(ch_dst[0][k], 0, (frames + 8) * sizeof (int32_t));
+                memset(ch_dst[1][k], 0, (frames + 8) * sizeof (int32_t));
+            }
+            ref->deinterleave_s32(s32_src + 1, ch_dst[0], c, frames);
+            ops->deinterleave_s32(s32_src + 1, ch_dst[1], c, frames);
+            for (k = 0; k < c; k++) {
+                if (memcmp(ch_dst[0][k], ch_dst[1][k], (frames + 8) * sizeof (int32_t))) {
+                    printf("%s: deinterleave_s32 mismatch channels=%u frames=%zu\n", ops->name, c, frames);
+                    errors++;
+                    break;
+                }
+            }
+        }
+    }
+
+    return errors;
+}
+
+enum bench_kernel {
+    BENCH_S32_TO_FLOAT,
+    BENCH_S32_TO_S24_3LE,
+    BENCH_S16_TO_FLOAT,
+    BENCH_DEINTERLEAVE,
+};
+
+//返回每个采样点耗时(ns)
+static double bench(const struct adau19xx_convert_ops *ops, enum bench_kernel kernel, unsigned int channels,
+        double budget_ns) {
+    size_t n = (size_t) BENCH_BLOCK_FRAMES * channels;
+    unsigned long iters = 0;
+    double start = now_ns(), t;
+
+    do {
+        switch (kernel) {
+            case BENCH_S32_TO_FLOAT:
+                ops->s32_to_float(s32_src, f_dst[0], n);
+                break;
+            case BENCH_S32_TO_S24_3LE:
+                ops->s32_to_s24_3le(s32_src, b_dst[0], n);
+                break;
+            case BENCH_S16_TO_FLOAT:
+                ops->s16_to_float(s16_src, f_dst[0], n);
+                break;
+            case BENCH_DEINTERLEAVE:
+                ops->deinterleave_s32(s32_src, ch_dst[0], channels, BENCH_BLOCK_FRAMES);
+                break;
+        }
+        iters++;
+        t = now_ns();
+    } while (t - start < budget_ns);
+
+    return (t - start) / ((double) iters * n);
+}
+
+int main(int argc, char *argv[]) {
+    static const char *const kernel_names[] = {
+        [BENCH_S32_TO_FLOAT] = "s32_to_float",
+        [BENCH_S32_TO_S24_3LE] = "s32_to_s24_3le",
+        [BENCH_S16_TO_FLOAT] = "s16_to_float",
+        [BENCH_DEINTERLEAVE] = "deinterleave_s32",
+    };
+    static const unsigned int bench_channels[] = { 2, 4, 8, 16 };
+    const struct adau19xx_convert_ops *ops[BENCH_MAX_IMPLS];
+    size_t max_samples = (size_t) BENCH_BLOCK_FRAMES * BENCH_MAX_CHANNELS + 64;
+    double budget_ns = (argc > 1 ? atof(argv[1]) : 200) * 1e6;
+    double ns, ref_ns = 0;
+    int num, i, j, k, errors = 0;
+
+    s32_src = malloc(max_samples * sizeof (*s32_src));
+    s16_src = malloc(max_samples * sizeof (*s16_src));
+    for (i = 0; i < 2; i++) {
+        f_dst[i] = malloc(max_samples * sizeof (float));
+        b_dst[i] = malloc(max_samples * 3 + 64);
+        for (k = 0; k < BENCH_MAX_CHANNELS; k++)
+            ch_dst[i][k] = malloc((BENCH_BLOCK_FRAMES + 8) * sizeof (int32_t));
+    }
+
+    srand(1977);
+    fill_random(max_samples);
+
+    num = adau19xx_convert_impls(ops, BENCH_MAX_IMPLS);
+    printf("implementations:");
+    for (i = 0; i < num; i++)
+        printf(" %s", ops[i]->name);
+    printf(" (best: %s)\n", adau19xx_convert_best()->name);
+
+    for (i = 1; i < num; i++)
+        errors += verify(ops[0], ops[i]);
+    printf("verify: %s\n\n", errors ? "FAILED" : "ok");
+
+    printf("%-18s %-8s %-8s %10s %12s %8s\n", "kernel", "channels", "impl", "ns/sample", "Msamples/s", "speedup");
+    for (k = BENCH_S32_TO_FLOAT; k <= BENCH_DEINTERLEAVE; k++) {
+        for (j = 0; j < (int) (sizeof (bench_channels) / sizeof (bench_channels[0])); j++) {
+            for (i = 0; i < num; i++) {
+                ns = bench(ops[i], k, bench_channels[j], budget_ns);
+                if (i == 0)
+                    ref_ns = ns;
+                printf("%-18s %-8u %-8s %10.3f %12.1f %7.2fx\n", kernel_names[k], bench_channels[j],
+                        ops[i]->name, ns, 1e3 / ns, ref_ns / ns);
+            }
+        }
+    }
+
+    return errors ? 1 : 0;
+}
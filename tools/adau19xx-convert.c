@@ -0,0 +1,428 @@
+#include "adau19xx-convert.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ADAU19XX_CONVERT_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define ADAU19XX_CONVERT_NEON
+#include <arm_neon.h>
+#elif defined(__arm__)
+#warning "NEON not enabled, only the scalar implementation is built (see CONVERT_CFLAGS in Makefile)"
+#endif
+
+//乘2的整数次幂不引入舍入,各实现只在int->float时舍入一次,结果逐位一致
+#define ADAU19XX_S32_SCALE (1.0f / 2147483648.0f)
+#define ADAU19XX_S16_SCALE (1.0f / 32768.0f)
+
+//------------------------------------------------------------------------
+//标量参考实现,也用于SIMD实现的尾部
+
+static void adau19xx_scalar_s32_to_float(const int32_t *src, float *dst, size_t n) {
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        dst[i] = (float) src[i] * ADAU19XX_S32_SCALE;
+}
+
+static void adau19xx_scalar_s32_to_s24_3le(const int32_t *src, uint8_t *dst, size_t n) {
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        uint32_t v = (uint32_t) src[i];
+
+        dst[3 * i] = v >> 8;
+        dst[3 * i + 1] = v >> 16;
+        dst[3 * i + 2] = v >> 24;
+    }
+}
+
+static void adau19xx_scalar_s16_to_float(const int16_t *src, float *dst, size_t n) {
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        dst[i] = (float) src[i] * ADAU19XX_S16_SCALE;
+}
+
+//从第start帧开始处理,SIMD实现用它处理不足一组的尾部
+static void adau19xx_scalar_deinterleave_from(const int32_t *src, int32_t *const *dst, unsigned int channels,
+        size_t start, size_t frames) {
+    size_t f;
+    unsigned int c;
+
+    for (f = start; f < frames; f++) {
+        for (c = 0; c < channels; c++)
+            dst[c][f] = src[f * channels + c];
+    }
+}
+
+static void adau19xx_scalar_deinterleave_s32(const int32_t *src, int32_t *const *dst, unsigned int channels,
+        size_t frames) {
+    adau19xx_scalar_deinterleave_from(src, dst, channels, 0, frames);
+}
+
+static const struct adau19xx_convert_ops adau19xx_scalar_ops = {
+    .name = "scalar",
+    .s32_to_float = adau19xx_scalar_s32_to_float,
+    .s32_to_s24_3le = adau19xx_scalar_s32_to_s24_3le,
+    .s16_to_float = adau19xx_scalar_s16_to_float,
+    .deinterleave_s32 = adau19xx_scalar_deinterleave_s32,
+};
+
+#ifdef ADAU19XX_CONVERT_X86
+
+//------------------------------------------------------------------------
+//SSSE3:打包24位需要pshufb
+
+__attribute__((target("ssse3")))
+static void adau19xx_ssse3_s32_to_float(const int32_t *src, float *dst, size_t n) {
+    const __m128 scale = _mm_set1_ps(ADAU19XX_S32_SCALE);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i b = _mm_loadu_si128((const __m128i *) (src + i + 4));
+
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(a), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(b), scale));
+    }
+    adau19xx_scalar_s32_to_float(src + i, dst + i, n - i);
+}
+
+//每次16个采样点:4个向量各取高24位得12字节,拼成3个完整的16字节写入
+__attribute__((target("ssse3")))
+static void adau19xx_ssse3_s32_to_s24_3le(const int32_t *src, uint8_t *dst, size_t n) {
+    const __m128i pack = _mm_setr_epi8(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (src + i)), pack);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (src + i + 4)), pack);
+        __m128i c = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (src + i + 8)), pack);
+        __m128i d = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (src + i + 12)), pack);
+        uint8_t *out = dst + 3 * i;
+
+        _mm_storeu_si128((__m128i *) out, _mm_or_si128(a, _mm_slli_si128(b, 12)));
+        _mm_storeu_si128((__m128i *) (out + 16), _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+        _mm_storeu_si128((__m128i *) (out + 32), _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(d, 4)));
+    }
+    adau19xx_scalar_s32_to_s24_3le(src + i, dst + 3 * i, n - i);
+}
+
+__attribute__((target("ssse3")))
+static void adau19xx_ssse3_s16_to_float(const int16_t *src, float *dst, size_t n) {
+    const __m128 scale = _mm_set1_ps(ADAU19XX_S16_SCALE);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        //16位复制到32位的高低两半,再算术右移完成符号扩展
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    adau19xx_scalar_s16_to_float(src + i, dst + i, n - i);
+}
+
+//4帧 x 4声道转置,声道数为4的倍数时逐组处理
+__attribute__((target("ssse3")))
+static void adau19xx_ssse3_deinterleave_s32(const int32_t *src, int32_t *const *dst, unsigned int channels,
+        size_t frames) {
+    size_t f = 0;
+    unsigned int g;
+
+    if (channels == 2) {
+        for (; f + 4 <= frames; f += 4) {
+            __m128 a = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) (src + 2 * f)));
+            __m128 b = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) (src + 2 * f + 4)));
+
+            _mm_storeu_ps((float *) (dst[0] + f), _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps((float *) (dst[1] + f), _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+    } else if (channels % 4 == 0) {
+        for (; f + 4 <= frames; f += 4) {
+            const int32_t *row = src + f * channels;
+
+            for (g = 0; g < channels; g += 4) {
+                __m128i r0 = _mm_loadu_si128((const __m128i *) (row + g));
+                __m128i r1 = _mm_loadu_si128((const __m128i *) (row + channels + g));
+                __m128i r2 = _mm_loadu_si128((const __m128i *) (row + 2 * channels + g));
+                __m128i r3 = _mm_loadu_si128((const __m128i *) (row + 3 * channels + g));
+                __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+                __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+                __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+                __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+
+                _mm_storeu_si128((__m128i *) (dst[g] + f), _mm_unpacklo_epi64(t0, t1));
+                _mm_storeu_si128((__m128i *) (dst[g + 1] + f), _mm_unpackhi_epi64(t0, t1));
+                _mm_storeu_si128((__m128i *) (dst[g + 2] + f), _mm_unpacklo_epi64(t2, t3));
+                _mm_storeu_si128((__m128i *) (dst[g + 3] + f), _mm_unpackhi_epi64(t2, t3));
+            }
+        }
+    }
+    adau19xx_scalar_deinterleave_from(src, dst, channels, f, frames);
+}
+
+static const struct adau19xx_convert_ops adau19xx_ssse3_ops = {
+    .name = "ssse3",
+    .s32_to_float = adau19xx_ssse3_s32_to_float,
+    .s32_to_s24_3le = adau19xx_ssse3_s32_to_s24_3le,
+    .s16_to_float = adau19xx_ssse3_s16_to_float,
+    .deinterleave_s32 = adau19xx_ssse3_deinterleave_s32,
+};
+
+//------------------------------------------------------------------------
+//AVX2
+
+__attribute__((target("avx2")))
+static void adau19xx_avx2_s32_to_float(const int32_t *src, float *dst, size_t n) {
+    const __m256 scale = _mm256_set1_ps(ADAU19XX_S32_SCALE);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i *) (src + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *) (src + i + 8));
+
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(a), scale));
+        _mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(b), scale));
+    }
+    adau19xx_scalar_s32_to_float(src + i, dst + i, n - i);
+}
+
+//每128位通道内打包成12字节,再跨通道合并成低24字节;
+//每次写32字节,多出的8字节由下一次写入覆盖,因此最后至少留8个采样点给标量处理
+__attribute__((target("avx2")))
+static void adau19xx_avx2_s32_to_s24_3le(const int32_t *src, uint8_t *dst, size_t n) {
+    const __m256i pack = _mm256_setr_epi8(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1,
+            1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1);
+    const __m256i merge = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 8) {
+        __m256i v = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *) (src + i)), pack);
+
+        _mm256_storeu_si256((__m256i *) (dst + 3 * i), _mm256_permutevar8x32_epi32(v, merge));
+    }
+    adau19xx_scalar_s32_to_s24_3le(src + i, dst + 3 * i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void adau19xx_avx2_s16_to_float(const int16_t *src, float *dst, size_t n) {
+    const __m256 scale = _mm256_set1_ps(ADAU19XX_S16_SCALE);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m256i lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (src + i)));
+        __m256i hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (src + i + 8)));
+
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+        _mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+    }
+    adau19xx_scalar_s16_to_float(src + i, dst + i, n - i);
+}
+
+//2声道:每次8帧;8/16声道:8帧 x 8声道转置;4声道用SSSE3实现
+__attribute__((target("avx2")))
+static void adau19xx_avx2_deinterleave_s32(const int32_t *src, int32_t *const *dst, unsigned int channels,
+        size_t frames) {
+    size_t f = 0;
+    unsigned int g;
+
+    if (channels == 2) {
+        const __m256i split = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+        for (; f + 8 <= frames; f += 8) {
+            __m256i a = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *) (src + 2 * f)), split);
+            __m256i b = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *) (src + 2 * f + 8)), split);
+
+            _mm256_storeu_si256((__m256i *) (dst[0] + f), _mm256_permute2x128_si256(a, b, 0x20));
+            _mm256_storeu_si256((__m256i *) (dst[1] + f), _mm256_permute2x128_si256(a, b, 0x31));
+        }
+    } else if (channels % 8 == 0) {
+        for (; f + 8 <= frames; f += 8) {
+            const int32_t *row = src + f * channels;
+
+            for (g = 0; g < channels; g += 8) {
+                const int32_t *p = row + g;
+                __m256i r0 = _mm256_loadu_si256((const __m256i *) p);
+                __m256i r1 = _mm256_loadu_si256((const __m256i *) (p + channels));
+                __m256i r2 = _mm256_loadu_si256((const __m256i *) (p + 2 * channels));
+                __m256i r3 = _mm256_loadu_si256((const __m256i *) (p + 3 * channels));
+                __m256i r4 = _mm256_loadu_si256((const __m256i *) (p + 4 * channels));
+                __m256i r5 = _mm256_loadu_si256((const __m256i *) (p + 5 * channels));
+                __m256i r6 = _mm256_loadu_si256((const __m256i *) (p + 6 * channels));
+                __m256i r7 = _mm256_loadu_si256((const __m256i *) (p + 7 * channels));
+                __m256i t0 = _mm256_unpacklo_epi32(r0, r1);
+                __m256i t1 = _mm256_unpackhi_epi32(r0, r1);
+                __m256i t2 = _mm256_unpacklo_epi32(r2, r3);
+                __m256i t3 = _mm256_unpackhi_epi32(r2, r3);
+                __m256i t4 = _mm256_unpacklo_epi32(r4, r5);
+                __m256i t5 = _mm256_unpackhi_epi32(r4, r5);
+                __m256i t6 = _mm256_unpacklo_epi32(r6, r7);
+                __m256i t7 = _mm256_unpackhi_epi32(r6, r7);
+                //每个128位通道内是4x4转置的结果:u0~u3为帧0~3,u4~u7为帧4~7;低通道声道0~3,高通道声道4~7
+                __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+                __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+                __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+                __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+                __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+                __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+                __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+                __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+                _mm256_storeu_si256((__m256i *) (dst[g] + f), _mm256_permute2x128_si256(u0, u4, 0x20));
+                _mm256_storeu_si256((__m256i *) (dst[g + 1] + f), _mm256_permute2x128_si256(u1, u5, 0x20));
+                _mm256_storeu_si256((__m256i *) (dst[g + 2] + f), _mm256_permute2x128_si256(u2, u6, 0x20));
+                _mm256_storeu_si256((__m256i *) (dst[g + 3] + f), _mm256_permute2x128_si256(u3, u7, 0x20));
+                _mm256_storeu_si256((__m256i *) (dst[g + 4] + f), _mm256_permute2x128_si256(u0, u4, 0x31));
+                _mm256_storeu_si256((__m256i *) (dst[g + 5] + f), _mm256_permute2x128_si256(u1, u5, 0x31));
+                _mm256_storeu_si256((__m256i *) (dst[g + 6] + f), _mm256_permute2x128_si256(u2, u6, 0x31));
+                _mm256_storeu_si256((__m256i *) (dst[g + 7] + f), _mm256_permute2x128_si256(u3, u7, 0x31));
+            }
+        }
+    } else if (channels == 4) {
+        adau19xx_ssse3_deinterleave_s32(src, dst, channels, frames);
+        return;
+    }
+    adau19xx_scalar_deinterleave_from(src, dst, channels, f, frames);
+}
+
+static const struct adau19xx_convert_ops adau19xx_avx2_ops = {
+    .name = "avx2",
+    .s32_to_float = adau19xx_avx2_s32_to_float,
+    .s32_to_s24_3le = adau19xx_avx2_s32_to_s24_3le,
+    .s16_to_float = adau19xx_avx2_s16_to_float,
+    .deinterleave_s32 = adau19xx_avx2_deinterleave_s32,
+};
+
+#endif
+
+#ifdef ADAU19XX_CONVERT_NEON
+
+//------------------------------------------------------------------------
+//NEON:定点转换指令一步完成int->float和缩放
+
+static void adau19xx_neon_s32_to_float(const int32_t *src, float *dst, size_t n) {
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        vst1q_f32(dst + i, vcvtq_n_f32_s32(vld1q_s32(src + i), 31));
+        vst1q_f32(dst + i + 4, vcvtq_n_f32_s32(vld1q_s32(src + i + 4), 31));
+    }
+    adau19xx_scalar_s32_to_float(src + i, dst + i, n - i);
+}
+
+//按字节4路解交织读入16个采样点,丢掉最低字节后3路交织写出
+static void adau19xx_neon_s32_to_s24_3le(const int32_t *src, uint8_t *dst, size_t n) {
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        uint8x16x4_t v = vld4q_u8((const uint8_t *) (src + i));
+        uint8x16x3_t out = { { v.val[1], v.val[2], v.val[3] } };
+
+        vst3q_u8(dst + 3 * i, out);
+    }
+    adau19xx_scalar_s32_to_s24_3le(src + i, dst + 3 * i, n - i);
+}
+
+static void adau19xx_neon_s16_to_float(const int16_t *src, float *dst, size_t n) {
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        int16x8_t v = vld1q_s16(src + i);
+
+        vst1q_f32(dst + i, vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(v)), 15));
+        vst1q_f32(dst + i + 4, vcvtq_n_f32_s32(vmovl_s16(vget_high_s16(v)), 15));
+    }
+    adau19xx_scalar_s16_to_float(src + i, dst + i, n - i);
+}
+
+static void adau19xx_neon_deinterleave_s32(const int32_t *src, int32_t *const *dst, unsigned int channels,
+        size_t frames) {
+    size_t f = 0;
+    unsigned int g;
+
+    if (channels == 2) {
+        for (; f + 4 <= frames; f += 4) {
+            int32x4x2_t v = vld2q_s32(src + 2 * f);
+
+            vst1q_s32(dst[0] + f, v.val[0]);
+            vst1q_s32(dst[1] + f, v.val[1]);
+        }
+    } else if (channels % 4 == 0) {
+        for (; f + 4 <= frames; f += 4) {
+            const int32_t *row = src + f * channels;
+
+            for (g = 0; g < channels; g += 4) {
+                int32x4x2_t p = vtrnq_s32(vld1q_s32(row + g), vld1q_s32(row + channels + g));
+                int32x4x2_t q = vtrnq_s32(vld1q_s32(row + 2 * channels + g), vld1q_s32(row + 3 * channels + g));
+
+                vst1q_s32(dst[g] + f, vcombine_s32(vget_low_s32(p.val[0]), vget_low_s32(q.val[0])));
+                vst1q_s32(dst[g + 1] + f, vcombine_s32(vget_low_s32(p.val[1]), vget_low_s32(q.val[1])));
+                vst1q_s32(dst[g + 2] + f, vcombine_s32(vget_high_s32(p.val[0]), vget_high_s32(q.val[0])));
+                vst1q_s32(dst[g + 3] + f, vcombine_s32(vget_high_s32(p.val[1]), vget_high_s32(q.val[1])));
+            }
+        }
+    }
+    adau19xx_scalar_deinterleave_from(src, dst, channels, f, frames);
+}
+
+static const struct adau19xx_convert_ops adau19xx_neon_ops = {
+    .name = "neon",
+    .s32_to_float = adau19xx_neon_s32_to_float,
+    .s32_to_s24_3le = adau19xx_neon_s32_to_s24_3le,
+    .s16_to_float = adau19xx_neon_s16_to_float,
+    .deinterleave_s32 = adau19xx_neon_deinterleave_s32,
+};
+
+#endif
+
+//------------------------------------------------------------------------
+
+int adau19xx_convert_impls(const struct adau19xx_convert_ops **ops, int max) {
+    int n = 0;
+
+    if (n < max)
+        ops[n++] = &adau19xx_scalar_ops;
+#ifdef ADAU19XX_CONVERT_X86
+    __builtin_cpu_init();
+    if (n < max && __builtin_cpu_supports("ssse3"))
+        ops[n++] = &adau19xx_ssse3_ops;
+    if (n < max && __builtin_cpu_supports("avx2"))
+        ops[n++] = &adau19xx_avx2_ops;
+#endif
+#ifdef ADAU19XX_CONVERT_NEON
+    if (n < max)
+        ops[n++] = &adau19xx_neon_ops;
+#endif
+    return n;
+}
+
+//多线程同时首次调用时各自检测,结果相同,无需加锁
+const struct adau19xx_convert_ops *adau19xx_convert_best(void) {
+    static const struct adau19xx_convert_ops *best;
+    const struct adau19xx_convert_ops *ops[4];
+
+    if (!best)
+        best = ops[adau19xx_convert_impls(ops, 4) - 1];
+    return best;
+}
+
+void adau19xx_s32_to_float(const int32_t *src, float *dst, size_t n) {
+    adau19xx_convert_best()->s32_to_float(src, dst, n);
+}
+
+void adau19xx_s32_to_s24_3le(const int32_t *src, uint8_t *dst, size_t n) {
+    adau19xx_convert_best()->s32_to_s24_3le(src, dst, n);
+}
+
+void adau19xx_s16_to_float(const int16_t *src, float *dst, size_t n) {
+    adau19xx_convert_best()->s16_to_float(src, dst, n);
+}
+
+void adau19xx_deinterleave_s32(const int32_t *src, int32_t *const *dst, unsigned int channels, size_t frames) {
+    adau19xx_convert_best()->deinterleave_s32(src, dst, channels, frames);
+}
@@ -0,0 +1,43 @@
+#ifndef _ADAU19XX_CONVERT_H
+#define _ADAU19XX_CONVERT_H
+
+//adau19xx录音数据转换:驱动以S32_LE容器输出24位有效数据(sig_bits = 24)
+//  s32_to_float      S32 -> float,满量程为[-1.0, 1.0)
+//  s32_to_s24_3le    S32 -> 紧凑24位,取高24位
+//  s16_to_float      S16 -> float
+//  deinterleave_s32  交织 -> 每声道一个缓冲区,2/4/8/16声道有SIMD实现,其他声道数走标量
+//同一组实现的输出与标量实现逐位一致
+//x86运行时按CPU选择SSSE3/AVX2,ARM编译时开启NEON
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct adau19xx_convert_ops {
+    const char *name;
+    //n为采样点数(帧数 x 声道数)
+    void (*s32_to_float)(const int32_t *src, float *dst, size_t n);
+    void (*s32_to_s24_3le)(const int32_t *src, uint8_t *dst, size_t n);
+    void (*s16_to_float)(const int16_t *src, float *dst, size_t n);
+    void (*deinterleave_s32)(const int32_t *src, int32_t *const *dst, unsigned int channels, size_t frames);
+};
+
+//当前CPU可用的实现,ops[0]为标量参考实现,最后一个为最快的实现;返回个数
+int adau19xx_convert_impls(const struct adau19xx_convert_ops **ops, int max);
+
+//当前CPU上最快的实现
+const struct adau19xx_convert_ops *adau19xx_convert_best(void);
+
+void adau19xx_s32_to_float(const int32_t *src, float *dst, size_t n);
+void adau19xx_s32_to_s24_3le(const int32_t *src, uint8_t *dst, size_t n);
+void adau19xx_s16_to_float(const int16_t *src, float *dst, size_t n);
+void adau19xx_deinterleave_s32(const int32_t *src, int32_t *const *dst, unsigned int channels, size_t frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif